@@ -4,1062 +4,6599 @@
 #include <unordered_map>
 #include <cmath>
 #include <list>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include <climits>
 #include <sstream>
 #include <fstream>
 #include <ctime>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
 /**
- * @brief A file system which allocates contigous blocks of memory to each file.
- * 
- * @tparam N size of the memory
+ * @brief how much each filesystem logs.
+ *
+ * QUIET prints errors only, SUMMARY adds the one-line-per-operation messages,
+ * TRACE adds the per-block read/write/allocate lines.
  */
-template<size_t N = 1024>
-class ContiguousFileSystem{
-    public:
+enum Verbosity { QUIET, SUMMARY, TRACE };
+
+// compile-time kill switch : building with -DFS_NO_TRACE makes fs_trace a
+// constant false, so the per-block formatting code is dead and removed from
+// the hot loops entirely.
+#ifdef FS_NO_TRACE
+constexpr bool fs_trace_enabled = false;
+#else
+constexpr bool fs_trace_enabled = true;
+#endif
+
+inline bool fs_trace(Verbosity v){ return fs_trace_enabled && v == TRACE; }
+inline bool fs_summary(Verbosity v){ return v >= SUMMARY; }
+
+// compile-time kill switch for instrumentation : building with -DFS_NO_STATS
+// turns every counter update and clock read into dead code.
+#ifdef FS_NO_STATS
+constexpr bool fs_stats_enabled = false;
+#else
+constexpr bool fs_stats_enabled = true;
+#endif
 
-    enum Strategy {FIRST_FIT, BEST_FIT, NEXT_FIT, WORST_FIT};
+/**
+ * @brief per-instance instrumentation counters.
+ *
+ * cumulative counters plus the scan length of the most recent allocation, so
+ * a slow create() can be attributed to fragmentation (long scans, many holes
+ * examined) rather than map growth (rehashes) or vice versa.
+ */
+struct FsStats{
+    long long creates = 0;          // instrumented create() calls.
+    long long deletes = 0;          // instrumented delete_file() calls.
+    long long scan_steps = 0;       // allocator scan work : summary nodes and
+                                    // words visited, chain blocks spliced,
+                                    // free runs carved.
+    long long last_scan_steps = 0;  // scan work of the most recent search.
+    long long holes_examined = 0;   // free runs inspected by fit searches.
+    long long free_runs = 0;        // current free-list length, filled by get_stats().
+    long long rehashes = 0;         // growth rehashes of the name intern table.
+    long long create_ns = 0;        // summed create() wall time.
+    long long delete_ns = 0;        // summed delete_file() wall time.
+};
 
-    class File {
-        int filesize;
-        int start_block;
-        File(int filesize, int start) : filesize(filesize), start_block(start) {}
-        friend class ContiguousFileSystem;
-    };
+/**
+ * @brief scoped timer charging its lifetime to one FsStats counter.
+ *
+ * compiles to nothing when stats are disabled.
+ */
+struct StatsTimer{
+    long long* sink;
+    chrono::steady_clock::time_point t0;
+    StatsTimer(long long& ns) : sink(&ns){
+        if constexpr (fs_stats_enabled)
+            t0 = chrono::steady_clock::now();
+    }
+    ~StatsTimer(){
+        if constexpr (fs_stats_enabled)
+            *sink += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    }
+};
 
-    /**
-     * @brief Construct a new Contiguous File System object
-     * 
-     * @param alg strategy for finding a hole. FIRST_FIT/BEST_FIT/WORST_FIT/NEXT_FIT. default = FIRST_FIT.
-     */
-    ContiguousFileSystem(Strategy alg = ContiguousFileSystem<N> :: FIRST_FIT) : memory_size(N), 
-                                                     used_memory(0),
-                                                     start_index(0), 
-                                                     strategy(alg) {}
-    
-    /**
-     * @brief Creates a file of given size. Allocates contiguous blocks of memory.
-     * 
-     * @param filename name of the file.
-     * @param filesize size of the file.
-     */
-    void create(string filename, int filesize) {
-        if(file_map.find(filename) != file_map.end()){
-            cerr << "ContigousFileSystem::create() : Filename " << filename << " already taken\n";
-            return;
-        }
+/**
+ * @brief host-heap bytes behind one filesystem instance, by structure.
+ *
+ * the numbers come from container element counts and the usual libstdc++
+ * node overheads - close enough to size a deployment against, not
+ * allocator-exact. get_storage_efficiency() reports the simulated blocks;
+ * this reports what the simulator itself costs the host.
+ */
+struct MemoryFootprint{
+    size_t block_store = 0;   // data-plane bytes, bitmaps, next tables, chain arenas.
+    size_t file_records = 0;  // File/extent-table slabs and their per-file vectors.
+    size_t free_lists = 0;    // allocator bookkeeping : hole maps, freelists, buddy buckets.
+    size_t name_map = 0;      // namespace tree, intern pool and handle tables.
+
+    size_t total() const {
+        return block_store + file_records + free_lists + name_map;
+    }
+};
 
-        // get the starting block of the alloted chunk.
-        int start = get_index(filesize);
-        
-        // if the required size can't be alloted contiguously return.
-        if(start == -1){
-            cerr << "ContiguousFileSystem::create() : Cannot allocate " << filesize << " blocks for " << filename << endl;
-            return;
-        }
+// per-element heap cost of the standard containers, as libstdc++ lays them
+// out : rb-tree nodes carry three pointers plus color, hash nodes a forward
+// pointer, deques allocate fixed 512-byte chunks. vectors charge capacity,
+// not size, since reserved-but-unused memory is exactly what gets budgeted.
+template<typename K, typename V>
+size_t map_heap_bytes(const map<K, V>& m){
+    return m.size() * (sizeof(pair<const K, V>) + 32);
+}
 
-        cout << "ContiguousFileSystem::create() : File " << filename << " created with starting block - " << start << endl;
+template<typename T>
+size_t set_heap_bytes(const multiset<T>& s){
+    return s.size() * (sizeof(T) + 32);
+}
 
-        // mark the blocks as used.
-        for(int i = 0; i < filesize; i++){
-            memory_map.set(i+start);
-        }
+template<typename K, typename V>
+size_t hash_heap_bytes(const unordered_map<K, V>& m){
+    return m.size() * (sizeof(pair<const K, V>) + 16) + m.bucket_count() * sizeof(void*);
+}
 
-        File* fp = new File(filesize, start);
-        used_memory += filesize;
-        file_map[filename] = fp;
-        return;
-    }
+template<typename T>
+size_t hash_heap_bytes(const unordered_set<T>& s){
+    return s.size() * (sizeof(T) + 16) + s.bucket_count() * sizeof(void*);
+}
 
-    /**
-     * @brief reads 'size' blocks of the file from given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to read.
-     * @param offset block number to start reading.
-     * @return int - number of block accesses taken to read the file.
-     */
-    int read(string filename, int size=-1, int offset = 0) {
-        int block_access = 1;
+template<typename T>
+size_t vec_heap_bytes(const vector<T>& v){
+    return v.capacity() * sizeof(T);
+}
 
-        //if file is not present in the filesytem, return.
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "ContiguousFileSystem:read() : File " << filename << " not found\n";
-            return block_access;
-        }
-        
-        File* fp = file_map[filename];
+template<typename T>
+size_t deque_heap_bytes(const deque<T>& d){
+    size_t per_chunk = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    return ((d.size() + per_chunk - 1) / per_chunk) * per_chunk * sizeof(T);
+}
 
-        size = (size==-1) ? fp->filesize : size;
+// strings below the small-string buffer live inline and cost nothing extra.
+inline size_t string_heap_bytes(const string& s){
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
 
-        // read blocks from the offset.
-        int read = 0;
-        for(int i = 0; i < fp->filesize && read < size; i++){
-            if (i >= offset){
-                cout << "ContiguousFileSystem:read() : Reading block " << fp->start_block + i << endl;
-                read++;
-            }
-            block_access++;
-        }
+/**
+ * @brief point-in-time picture of how fragmented a filesystem's free space is.
+ *
+ * filled from the incrementally maintained free-run index - no bitmap scan
+ * happens on query, so it is cheap enough to poll after every operation.
+ */
+struct FragmentationStats{
+    int hole_count = 0;       // maximal free runs.
+    int largest_hole = 0;     // blocks in the biggest free run.
+    int free_blocks = 0;      // total free blocks across all runs.
+    float mean_hole = 0;      // free_blocks / hole_count.
+    float external_frag = 0;  // 1 - largest_hole / free_blocks : the share of
+                              // free space unusable by a largest-hole request.
+};
+
+/**
+ * @brief outcome of one read/write : blocks actually moved and modeled cost.
+ */
+struct IoResult{
+    int blocks = 0;      // data blocks actually read or written.
+    long long cost = 0;  // modeled cost, including the metadata access.
+};
 
-        cout << "ContiguousFileSystem:read() : Total blocks read : " << read << endl;
+/**
+ * @brief IoResult slot whose fields are individually atomic.
+ *
+ * every read and write updates the per-instance io-accounting scratch, so
+ * overlapping reads through the concurrent wrapper must not tear it. the
+ * fields are stored as separate relaxed atomics : a concurrent snapshot may
+ * pair blocks and cost from two different ops, but each field is always a
+ * value some op actually produced, and single-threaded use pays two plain
+ * stores. (one 16-byte atomic would drag in libatomic.)
+ */
+struct AtomicIoResult{
+    atomic<int> blocks{0};
+    atomic<long long> cost{0};
 
-        return size+1;
+    void operator=(const IoResult& io){
+        blocks.store(io.blocks, memory_order_relaxed);
+        cost.store(io.cost, memory_order_relaxed);
     }
 
-    /**
-     * @brief removes the given file from the filesystem.
-     * 
-     * @param filename name of the file.
-     */
-    void delete_file(string filename){
-        //if file is not present in the filesytem, return.
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "ContigousFileSystem::delete(): File not found.\n";
-            return;
-        }
+    operator IoResult() const {
+        IoResult out;
+        out.blocks = blocks.load(memory_order_relaxed);
+        out.cost = cost.load(memory_order_relaxed);
+        return out;
+    }
+};
+
+/**
+ * @brief pluggable cost model for block touches.
+ *
+ * a data-block touch costs sequential_cost when the block is physically
+ * adjacent to the previously touched one and seek_cost otherwise; metadata
+ * hops (chunk headers, the initial lookup) always charge seek_cost. the
+ * defaults charge 1 everywhere, reproducing the historical flat counting.
+ */
+struct CostModel{
+    long long seek_cost = 1;
+    long long sequential_cost = 1;
+};
+
+/**
+ * @brief charges one data-block touch against the running op.
+ *
+ * cached touches move a block but cost nothing, matching how cache hits are
+ * skipped by the block_access counters.
+ */
+inline void charge_touch(const CostModel& m, IoResult& io, int& prev, int block, bool cached){
+    io.blocks++;
+    if(!cached)
+        io.cost += (block == prev + 1) ? m.sequential_cost : m.seek_cost;
+    prev = block;
+}
 
-        ContiguousFileSystem::File* fp = file_map[filename];
+// ---- metadata snapshot helpers ----
+//
+// Snapshots are flat and pointer-free : POD fields, arrays, and a string per
+// filename, written with bulk writes and read back through one mmap of the
+// snapshot file. Each class writes a one-byte tag after the shared magic so
+// a snapshot can't be loaded into the wrong kind of filesystem.
 
-        // mark the blocks as available.
-        cout << "ContiguousFileSystem::delete_file() : deallocating blocks\n";
-        for(int i = 0; i < fp->filesize; i++){
-            memory_map.reset(fp->start_block + i);
-        }
+const char SNAP_MAGIC[8] = {'F','S','S','N','A','P','0','1'};
 
-        // delete metafile.
-        used_memory -= fp->filesize;
-        delete fp;
-        file_map.erase(filename);
-        cout << "ContiguousFileSystem::delete_file() : " <<  filename << " deleted\n";
+template<typename T>
+void snap_put(ofstream& out, const T& v){
+    out.write((const char*)&v, sizeof(T));
+}
+
+inline void snap_put_str(ofstream& out, const string& s){
+    uint32_t len = s.size();
+    snap_put(out, len);
+    out.write(s.data(), len);
+}
+
+template<typename T>
+bool snap_get(const char*& p, const char* e, T& v){
+    if(p + sizeof(T) > e)
+        return false;
+    memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+inline bool snap_get_str(const char*& p, const char* e, string& s){
+    uint32_t len;
+    if(!snap_get(p, e, len) || p + len > e)
+        return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+/**
+ * @brief true iff [start, start+len) is a valid block range for n blocks.
+ *
+ * loaders run every decoded range through this before indexing with it:
+ * the reads above only guarantee the bytes came from the mapping, not
+ * that a forged snapshot's values stay inside the filesystem.
+ */
+inline bool snap_range_ok(int start, int len, size_t n){
+    return start >= 0 && len >= 0 && (size_t)start + (size_t)len <= n;
+}
+
+/**
+ * @brief memory-maps a snapshot file and checks the magic and class tag.
+ *
+ * @param path snapshot file.
+ * @param tag one-byte class tag expected after the magic.
+ * @param len set to the mapping length; caller munmaps the returned base.
+ * @param p set to the read cursor positioned after the header.
+ * @return const char* - mapping base, nullptr on failure.
+ */
+inline const char* snap_map(const char* path, char tag, size_t& len, const char*& p){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return nullptr;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SNAP_MAGIC) + 1){
+        close(fd);
+        return nullptr;
     }
+    len = st.st_size;
+    const char* base = (const char*)mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED)
+        return nullptr;
+    if(memcmp(base, SNAP_MAGIC, sizeof(SNAP_MAGIC)) != 0 || base[sizeof(SNAP_MAGIC)] != tag){
+        munmap((void*)base, len);
+        return nullptr;
+    }
+    p = base + sizeof(SNAP_MAGIC) + 1;
+    return base;
+}
+
+/**
+ * @brief A simulated buffer cache of disk blocks.
+ *
+ * Sits in front of the per-block accesses of any filesystem : access()
+ * returns whether the block was already cached, and the filesystems skip
+ * counting a block access on hits. One instance can be shared by several
+ * filesystems. Eviction policy follows the Strategy-style enum pattern.
+ */
+class BufferCache{
+    public:
+
+    enum Policy { LRU, CLOCK };
 
     /**
-     * @brief writes 'size' blocks starting from the given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to write.
-     * @param offset starting block to write from.
-     * @return int - number of block accesses taken to write the file
+     * @brief Construct a new Buffer Cache object
+     *
+     * @param capacity number of blocks the cache can hold.
+     * @param policy eviction policy. LRU/CLOCK. default = LRU.
      */
-    int write(string filename, int size, int offset = 0){
-        int block_access = 1;
-        //if file is not present in the filesytem, return.
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "ContigousFileSystem::write() : File " << filename << " not found\n";
-            return block_access;
+    BufferCache(int capacity, Policy policy = LRU) : capacity(capacity), policy(policy),
+                                                     hits(0), misses(0), evictions(0), hand(0) {}
+
+    /**
+     * @brief runs one block access through the cache, evicting if needed.
+     *
+     * @param block physical block id.
+     * @return true if the block was already cached (a hit).
+     */
+    bool access(int block){
+        if(capacity <= 0)
+            return false;
+        if(policy == LRU)
+            return access_lru(block);
+        return access_clock(block);
+    }
+
+    long long get_hits(){ return hits; }
+    long long get_misses(){ return misses; }
+    long long get_evictions(){ return evictions; }
+
+    private:
+
+    bool access_lru(int block){
+        auto it = slot.find(block);
+        if(it != slot.end()){
+            // move to the front of the recency list.
+            lru.splice(lru.begin(), lru, it->second);
+            hits++;
+            return true;
         }
+        misses++;
+        if((int)lru.size() == capacity){
+            slot.erase(lru.back());
+            lru.pop_back();
+            evictions++;
+        }
+        lru.push_front(block);
+        slot[block] = lru.begin();
+        return false;
+    }
 
-        ContiguousFileSystem::File* fp = file_map[filename];
+    bool access_clock(int block){
+        auto it = frame_of.find(block);
+        if(it != frame_of.end()){
+            frames[it->second].second = true;
+            hits++;
+            return true;
+        }
+        misses++;
+        if((int)frames.size() < capacity){
+            frame_of[block] = frames.size();
+            frames.push_back({block, true});
+            return false;
+        }
+        // advance the hand past referenced frames, clearing their bits.
+        while(frames[hand].second){
+            frames[hand].second = false;
+            hand = (hand + 1) % capacity;
+        }
+        frame_of.erase(frames[hand].first);
+        frames[hand] = {block, true};
+        frame_of[block] = hand;
+        hand = (hand + 1) % capacity;
+        evictions++;
+        return false;
+    }
 
-        if(size + offset > fp->filesize){
-            // in case of overflow, check if contiguous blocks can be allotted.
-            int req = size + offset - fp->filesize;
-            int available;
-            int end = fp->start_block + fp->filesize;
+    const int capacity;
+    Policy policy;
+    long long hits, misses, evictions;
+    list<int> lru;                                 // LRU recency order, front = most recent.
+    unordered_map<int, list<int>::iterator> slot;  // LRU block -> list position.
+    vector<pair<int, bool>> frames;                // CLOCK frames : (block, referenced).
+    unordered_map<int, int> frame_of;              // CLOCK block -> frame index.
+    int hand;                                      // CLOCK hand position.
+};
 
-            for(available = 0; available < req; available++){
-                if(memory_map[available+end] == 1)
-                    break;
-            }
+// bytes of payload carried by one block of the data plane.
+constexpr size_t FS_BLOCK_SIZE = 512;
 
-            if(available != req){
-                cerr << "ContiguousFileSystem::write() : Blocks for given size cannot be allocated.\n";
-                return block_access;
-            }
+/**
+ * @brief one contiguous run of bytes inside a filesystem's backing store.
+ *
+ * the scatter/gather read path hands these out directly, so a caller can walk
+ * a file's data without any intermediate copy.
+ */
+struct BlockView{
+    char* base;
+    size_t len;
+};
 
-            //if it is possible to allot contiguous blocks, mark them as used.
-            for(available = 0; available < req; available++)
-                memory_map.set(available+end);
-            
+/**
+ * @brief clips a file's physical runs to a byte range and returns views into
+ * the backing store, one per contiguous run touched.
+ *
+ * @param store base address of the backing store.
+ * @param runs physical (start block, block count) runs in file order.
+ * @param offset starting byte within the file.
+ * @param len number of bytes wanted.
+ */
+static vector<BlockView> runs_to_views(char* store, const vector<pair<int, int>>& runs, int offset, int len){
+    vector<BlockView> views;
+    long long pos = 0, end = (long long)offset + len;
+    for(auto& run : runs){
+        long long bytes = (long long)run.second * FS_BLOCK_SIZE;
+        long long lo = max((long long)offset, pos);
+        long long hi = min(end, pos + bytes);
+        if(lo < hi)
+            views.push_back({store + (long long)run.first * FS_BLOCK_SIZE + (lo - pos), (size_t)(hi - lo)});
+        pos += bytes;
+        if(pos >= end)
+            break;
+    }
+    return views;
+}
 
-            fp->filesize += req; 
+/**
+ * @brief copies the bytes behind a view list into a flat buffer.
+ *
+ * @return int - number of bytes copied.
+ */
+static int gather_bytes(const vector<BlockView>& views, char* dst){
+    int copied = 0;
+    for(auto& v : views){
+        memcpy(dst + copied, v.base, v.len);
+        copied += v.len;
+    }
+    return copied;
+}
 
-            used_memory += req;
-        }
+/**
+ * @brief copies a flat buffer into the blocks behind a view list.
+ *
+ * @return int - number of bytes copied.
+ */
+static int scatter_bytes(const vector<BlockView>& views, const char* src){
+    int copied = 0;
+    for(auto& v : views){
+        memcpy(v.base, src + copied, v.len);
+        copied += v.len;
+    }
+    return copied;
+}
 
-        int start = fp->start_block + offset;
-        for(int i = 0; i < size; i++){
-            block_access++;
-            cout << "ContigousFileSystem::write() : Writing block " <<  start + i << endl; 
-        }
+/**
+ * @brief trailing zero bits of a 64-bit word, 64 for zero.
+ */
+static int ctz64(uint64_t x){
+#if defined(__GNUC__)
+    return x ? __builtin_ctzll(x) : 64;
+#else
+    if(!x)
+        return 64;
+    int n = 0;
+    while(!(x & 1)){
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
 
-        cout << "ContigousFileSystem::write() : Total blocks written " << size << endl;
-        return size+1;
+/**
+ * @brief longest run, left-edge run and right-edge run of zero bits in a word.
+ *
+ * hops from zero-run to zero-run with ctz, so the cost is the number of runs
+ * rather than 64 bit tests.
+ */
+static void word_zero_runs(uint64_t word, int& max_run, int& prefix, int& suffix){
+    if(word == 0){
+        max_run = prefix = suffix = 64;
+        return;
     }
+    prefix = ctz64(word);
+    suffix = 0;
+    while(!(word & (1ULL << (63 - suffix))))
+        suffix++;
+    max_run = 0;
+    int bit = 0;
+    while(bit < 64){
+        int zeros = min(ctz64(word >> bit), 64 - bit);
+        max_run = max(max_run, zeros);
+        bit += zeros;
+        if(bit >= 64)
+            break;
+        bit += min(ctz64(~(word >> bit)), 64 - bit);
+    }
+}
+
+/**
+ * @brief hierarchical namespace shared by all of the filesystem classes.
+ *
+ * Path-like names ("logs/2026/08/app.log") are split on '/' and kept as a
+ * tree of per-directory child tables keyed by interned component ids, so a
+ * component spelling is stored and hashed once no matter how many paths
+ * share it. Exact lookup walks one table per component; enumeration and
+ * recursive delete under a directory touch only that subtree instead of
+ * scanning the whole namespace.
+ *
+ * @tparam FileT the owning filesystem's File record type.
+ */
+template<typename FileT>
+class DirTree{
+
+    struct Node{
+        unordered_map<int32_t, Node> children;  // component id -> subdirectory.
+        unordered_map<int32_t, FileT*> files;   // component id -> file here.
+    };
+
+    // interned component spellings : the deque keeps them at stable
+    // addresses so the id map can key on views into it.
+    deque<string> pool;
+    unordered_map<string_view, int32_t> ids;
+    Node root;
+    size_t count = 0;
 
     /**
-     * @brief Get the storage efficiency of the file system.
-     * 
-     * @return float - returns the ratio of used memory to the total memory size.
+     * @brief splits the next '/'-delimited component off the front of rest.
      */
-    float get_storage_efficiency(){
-        //cout << "used memory : " << used_memory << endl;
-        return (float)used_memory/N;
+    static string_view next_comp(string_view& rest){
+        size_t cut = rest.find('/');
+        string_view comp = rest.substr(0, cut);
+        rest = (cut == string_view::npos) ? string_view() : rest.substr(cut + 1);
+        return comp;
     }
 
-    protected:
-
-    bitset<N> memory_map;
-    unordered_map<string, File*> file_map;
-    const int memory_size;
-    int start_index;
-    Strategy strategy;
-    int used_memory;
-
     /**
-     * @brief finds the first hole that can accomodate the given size.
-     * 
-     * @param size size of the file to fit.
-     * @return int - block index of the first hole.
+     * @brief id of a component spelling, interning it on first sight.
      */
-    int first_fit(int size){
-        int i = 0;
-        while(i < memory_size){
-            if(memory_map[i] == 0){
-                int j = i;
-                //find the size of the hole.
-                while(j < memory_size && j < i+size && memory_map[j] == 0)
-                    j++;
-
-                //if the current hole can fit the size, return.
-                if(j == i+size)
-                    return i;
-                
-                i += j;
-            }
-            else    
-                i++;
-        }
-        return -1;
+    int32_t intern(string_view comp){
+        auto it = ids.find(comp);
+        if(it != ids.end())
+            return it->second;
+        pool.push_back(string(comp));
+        int32_t id = ids.size();
+        ids[pool.back()] = id;
+        return id;
     }
 
     /**
-     * @brief finds the smallest hole that can fit the given size.
-     * 
-     * @param size size of the file to fit.
-     * @return int - block index of the smallest hole.
+     * @brief id of a component spelling, -1 if it was never interned.
      */
-    int best_fit(int size){
-        int i = 0;
-        int min_size = INT_MAX;
-        int ind = -1;
-        
-        while(i < memory_size){
-            if(memory_map[i] == 0){
-                int j = i;
-                //find the size of the hole.
-                while(j < memory_size && memory_map[j] == 0)
-                    j++;
-                
-                // if the current hole is smaller, update ind.
-                if(j >= i+size && j-i <= min_size){
-                    min_size = j-i;
-                    ind = i;
-                }
+    int32_t known(string_view comp) const {
+        auto it = ids.find(comp);
+        return it == ids.end() ? -1 : it->second;
+    }
 
-                i = j;
-            }
-            else    
-                i++;
+    /**
+     * @brief walks to the directory node named by path, nullptr if absent.
+     *
+     * a trailing '/' (or an empty path, meaning the root) is accepted.
+     */
+    const Node* dir_node(string_view path) const {
+        const Node* node = &root;
+        while(!path.empty()){
+            string_view comp = next_comp(path);
+            if(comp.empty())
+                continue;
+            int32_t id = known(comp);
+            if(id == -1)
+                return nullptr;
+            auto it = node->children.find(id);
+            if(it == node->children.end())
+                return nullptr;
+            node = &it->second;
         }
+        return node;
+    }
 
-        return ind;
+    template<typename Fn>
+    void visit(const Node& node, Fn& fn) const {
+        for(auto& kv : node.files)
+            fn(kv.second);
+        for(auto& kv : node.children)
+            visit(kv.second, fn);
     }
 
+    public:
+
     /**
-     * @brief finds the largest hole that can fit the given size.
-     * 
-     * @param size size of the file to fit.
-     * @return int - block index of the largest hole.
+     * @brief exact lookup of a full path.
+     *
+     * @return FileT* - the file record, nullptr if absent.
      */
-    int worst_fit(int size){
-        int i = 0;
-        int max_size = 0;
-        int ind = -1;
-
-        while(i < memory_size){
-            if(memory_map[i] == 0){
-                int j = i;
-                //find the size of the hole
-                while(j < memory_size && memory_map[j] == 0)
-                    j++;
-                
-                // if the current hole is larger, update ind.
-                if(j >= i+size && j-i > max_size){
-                    max_size = j-i;
-                    ind = i;
-                }
-
-                i += j;
+    FileT* find(string_view path) const {
+        const Node* node = &root;
+        while(true){
+            string_view comp = next_comp(path);
+            int32_t id = known(comp);
+            if(id == -1)
+                return nullptr;
+            if(path.empty()){
+                auto it = node->files.find(id);
+                return it == node->files.end() ? nullptr : it->second;
             }
-            else    
-                i++;
+            auto it = node->children.find(id);
+            if(it == node->children.end())
+                return nullptr;
+            node = &it->second;
         }
-        return ind;
     }
 
     /**
-     * @brief finds the first hole that can fit the size starting from the point where the last search ended.
-     * 
-     * @param size size of the file to fit.
-     * @return int - block index of the hole.
+     * @brief inserts a file record, creating intermediate directories.
      */
-    int next_fit(int size){
-        int i = start_index;
-        int count = 0;
-        while(count < memory_size){
-            if(memory_map[i] == 0){
-                int j = i;
-                while(j < memory_size && j < i+size && memory_map[j] == 0)
-                    j++;
-
-                if(j == i+size){
-                    start_index = (j+i)%memory_size;
-                    return i;
-                }
-                
-                i = (i + j)%memory_size;
-                count += j;
-            }
-            else{    
-                i = (i+1)%memory_size;
-                count++;
+    void insert(string_view path, FileT* fp){
+        Node* node = &root;
+        while(true){
+            string_view comp = next_comp(path);
+            int32_t id = intern(comp);
+            if(path.empty()){
+                FileT*& slot = node->files[id];
+                if(!slot)
+                    count++;
+                slot = fp;
+                return;
             }
-
+            node = &node->children[id];
         }
-        return -1;
     }
 
     /**
-     * @brief Get the starting block index of the alloted contiguous block based on the strategy.
-     * 
-     * @param size size to fit.
-     * @return int starting index of the block.
+     * @brief removes a file record, pruning directories it leaves empty.
      */
-    int get_index(int size){
-        if(strategy == FIRST_FIT)
-            return first_fit(size);
-        else if(strategy == BEST_FIT)
-            return best_fit(size);
-        else if(strategy == WORST_FIT)
-            return worst_fit(size);
+    void erase(string_view path){
+        // remember the whole descent so emptied directories can be unlinked
+        // on the way back up; a capped stack would prune the wrong subtree
+        // on paths deeper than the cap.
+        vector<Node*> chain;
+        vector<int32_t> comp_id;
+        Node* node = &root;
+        while(true){
+            string_view comp = next_comp(path);
+            int32_t id = known(comp);
+            if(id == -1)
+                return;
+            if(path.empty()){
+                if(node->files.erase(id))
+                    count--;
+                break;
+            }
+            chain.push_back(node);
+            comp_id.push_back(id);
+            auto it = node->children.find(id);
+            if(it == node->children.end())
+                return;
+            node = &it->second;
+        }
+        while(!chain.empty() && node->files.empty() && node->children.empty()){
+            chain.back()->children.erase(comp_id.back());
+            node = chain.back();
+            chain.pop_back();
+            comp_id.pop_back();
+        }
+    }
+
+    /**
+     * @brief calls fn(FileT*) for every file in the namespace.
+     */
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        visit(root, fn);
+    }
+
+    /**
+     * @brief calls fn(FileT*) for every file under the given directory.
+     *
+     * @param dir directory path, with or without a trailing '/'.
+     */
+    template<typename Fn>
+    void for_each_under(string_view dir, Fn&& fn) const {
+        const Node* node = dir_node(dir);
+        if(node)
+            visit(*node, fn);
+    }
+
+    /**
+     * @brief detaches the subtree under dir and calls fn(FileT*) per file.
+     *
+     * the subtree is unlinked before fn runs, so fn may free the records
+     * without the traversal seeing a half-deleted tree.
+     *
+     * @return int - number of files removed.
+     */
+    template<typename Fn>
+    int erase_under(string_view dir, Fn&& fn){
+        Node* parent = nullptr;
+        int32_t last_id = -1;
+        Node* node = &root;
+        string_view rest = dir;
+        while(!rest.empty()){
+            string_view comp = next_comp(rest);
+            if(comp.empty())
+                continue;
+            int32_t id = known(comp);
+            if(id == -1)
+                return 0;
+            auto it = node->children.find(id);
+            if(it == node->children.end())
+                return 0;
+            parent = node;
+            last_id = id;
+            node = &it->second;
+        }
+        Node detached = move(*node);
+        if(parent)
+            parent->children.erase(last_id);
         else
-            return next_fit(size);
+            root = Node();
+        int removed = 0;
+        auto reap = [&](FileT* fp){ removed++; fn(fp); };
+        visit(detached, reap);
+        count -= removed;
+        return removed;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief drops every entry; interned spellings are kept for reuse.
+     */
+    void clear(){
+        root = Node();
+        count = 0;
+    }
+
+    // bucket count of the intern table, for the rehash counter : component
+    // spellings are the only keys the namespace still hashes.
+    size_t bucket_count() const {
+        return ids.bucket_count();
+    }
+
+    /**
+     * @brief estimated host-heap bytes behind the tree, intern pool included.
+     */
+    size_t footprint() const {
+        size_t bytes = hash_heap_bytes(ids) + deque_heap_bytes(pool);
+        for(const string& s : pool)
+            bytes += string_heap_bytes(s);
+        return bytes + node_bytes(root);
     }
 
+    private:
+
+    /**
+     * @brief recursive share of footprint() : one node's tables and its subtree.
+     */
+    static size_t node_bytes(const Node& n){
+        size_t bytes = hash_heap_bytes(n.children) + hash_heap_bytes(n.files);
+        for(auto& c : n.children)
+            bytes += node_bytes(c.second);
+        return bytes;
+    }
 };
 
 /**
- * @brief A file system which allocates linked list of blocks to each file.
- * 
- * @tparam N size of the memory.
+ * @brief hole-search strategy for ContiguousFileSystem.
+ *
+ * DYNAMIC defers the choice to the constructor argument; any other value
+ * pins the strategy into the template so the fit search inlines straight
+ * into the create/write hot path with no per-call dispatch.
  */
-template<size_t N = 1024>
-class LinkedFileSystem{
+enum FitStrategy { FIRST_FIT, BEST_FIT, NEXT_FIT, WORST_FIT, BUDDY, DYNAMIC };
 
-    private:
+/**
+ * @brief A file system which allocates contigous blocks of memory to each file.
+ *
+ * @tparam N size of the memory
+ * @tparam S fit strategy, pinned at compile time unless left DYNAMIC.
+ */
+template<size_t N = 1024, FitStrategy S = DYNAMIC>
+class ContiguousFileSystem{
+    public:
 
-    struct block{
-        int id;
-        block* next;
-        block(int id, block* next = nullptr){
-            this->id = id;
-            this->next = next;
-        }
-    };
+    // kept as members so existing call sites can keep spelling the strategy
+    // as ContiguousFileSystem<N>::BEST_FIT.
+    using Strategy = FitStrategy;
+    static constexpr Strategy FIRST_FIT = ::FIRST_FIT;
+    static constexpr Strategy BEST_FIT = ::BEST_FIT;
+    static constexpr Strategy NEXT_FIT = ::NEXT_FIT;
+    static constexpr Strategy WORST_FIT = ::WORST_FIT;
+    static constexpr Strategy BUDDY = ::BUDDY;
 
     class File {
         int filesize;
-        block* start_block;
-        File(int filesize, block* start) : filesize(filesize), start_block(start) {}
-        friend class LinkedFileSystem;
+        int start_block;
+        string name;      // so handle-based deletes can erase the map entry.
+        int handle = -1;  // slot in the handle table, -1 while unopened.
+        File(int filesize, int start) : filesize(filesize), start_block(start) {}
+        friend class ContiguousFileSystem;
     };
 
-    list<block*> free_list;
-    unordered_map<string, File*> file_map;
-    int used_memory;
-
-    public:
-
     /**
-     * @brief Construct a new Linked File System object
+     * @brief Construct a new Contiguous File System object
      * 
+     * @param alg strategy for finding a hole. FIRST_FIT/BEST_FIT/WORST_FIT/NEXT_FIT,
+     * or BUDDY for power-of-two chunk allocation. default = FIRST_FIT.
+     * ignored when the template already pins a strategy.
      */
-    LinkedFileSystem() : used_memory(0){
-        for(int i = 0; i < N; i++){
-            block* b = new block(i);
-            free_list.push_back(b);
-        }
+    ContiguousFileSystem(Strategy alg = FIRST_FIT) : memory_size(N),
+                                                     used_memory(0),
+                                                     start_index(0),
+                                                     strategy(S == DYNAMIC ? alg : S) {
+        // initially the whole memory is one free hole.
+        build_summary();
+        add_hole(0, N);
+        if(strategy == BUDDY)
+            buddy_rebuild();
     }
 
+    // file records live by value in a slab owned by the instance, so the
+    // filesystem moves wholesale but must not be copied (the maps hold
+    // pointers into the slab).
+    ContiguousFileSystem(ContiguousFileSystem&&) = default;
+    ContiguousFileSystem(const ContiguousFileSystem&) = delete;
+    
     /**
-     * @brief Creates a file of given size. Allocates non contiguous linked blocks of memory.
+     * @brief Creates a file of given size. Allocates contiguous blocks of memory.
      * 
      * @param filename name of the file.
      * @param filesize size of the file.
      */
-    void create(string filename, int size){
-        if(file_map.find(filename) != file_map.end()){
-            cerr << "LinkedFileSystem::create() : Filename already taken\n";
+    void create(string filename, int filesize) {
+        StatsTimer _t(stats.create_ns);
+        if constexpr (fs_stats_enabled)
+            stats.creates++;
+        size_t buckets = file_map.bucket_count();
+        if(file_map.find(filename)){
+            cerr << "ContigousFileSystem::create() : Filename " << filename << " already taken\n";
             return;
         }
 
-        //if there are less number of blocks in free list than required, return.
-        if(free_list.size() < size){
-            cerr << "LinkedFileSystem::write() : cannot allocate " << size << " blocks for " << filename << endl;
+        // bounded-metadata mode : refuse growth once host metadata passes the cap.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "ContiguousFileSystem::create() : metadata budget exceeded, cannot create " << filename << "\n";
+            return;
+        }
+
+        // a zero-size file owns no extent : letting the scan place one would
+        // hand back a used block (a zero run fits anywhere) and the hole
+        // split in allocate_extent would then corrupt the index.
+        if(filesize <= 0){
+            File* fp = alloc_file(0, -1);
+            fp->name = filename;
+            file_map.insert(filename, fp);
+            if constexpr (fs_stats_enabled)
+                if(file_map.bucket_count() != buckets)
+                    stats.rehashes++;
+            if(fs_summary(verbosity))
+                cout << "ContiguousFileSystem::create() : File " << filename << " created with no blocks" << endl;
             return;
         }
 
-        block* start = free_list.front();
-        free_list.pop_front();
+        // blocks actually reserved : BUDDY rounds the file up to a chunk.
+        int span = alloc_span(filesize);
+
+        // get the starting block of the alloted chunk.
+        int start = get_index(filesize);
 
-        File* fp = new File(size, start);
-        cout << "LinkedFileSystem::write() : File " << filename << " created with starting block " << start->id << endl;
+        // enough free blocks exist in total, just not contiguously : compact
+        // incrementally until a hole fits, if the caller opted in. BUDDY
+        // never compacts, its chunks must stay size-aligned.
+        if(start == -1 && strategy != BUDDY && auto_defrag && filesize <= memory_size - used_memory){
+            while(largest_hole() < filesize && defragment(filesize) > 0);
+            start = get_index(filesize);
+        }
 
-        // remove from free list and link it to the file.
-        for(int i = 1; i < size; i++){
-            start->next = free_list.front();
-            free_list.pop_front();
-            start = start->next;
+        // if the required size can't be alloted contiguously return.
+        if(start == -1){
+            cerr << "ContiguousFileSystem::create() : Cannot allocate " << filesize << " blocks for " << filename << endl;
+            return;
         }
 
-        used_memory += size;
+        if(fs_summary(verbosity))
+            cout << "ContiguousFileSystem::create() : File " << filename << " created with starting block - " << start << endl;
 
-        file_map[filename] = fp;
+        // mark the blocks as used.
+        allocate_extent(start, span);
+
+        File* fp = alloc_file(filesize, start);
+        fp->name = filename;
+        used_memory += span;
+        file_map.insert(filename, fp);
+        files_by_start[start] = fp;
+        if constexpr (fs_stats_enabled)
+            if(file_map.bucket_count() != buckets)
+                stats.rehashes++;
+        return;
     }
 
     /**
-     * @brief reads 'size' blocks of the file from given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to read.
-     * @param offset block number to start reading.
-     * @return int - number of block accesses taken to read the file.
+     * @brief creates a batch of files with one pass over the free holes.
+     *
+     * the batch is planned first : requests go into a size-ordered pending
+     * set and one address-ordered walk of the hole list hands each hole to
+     * the largest requests that still fit, so a burst of creates costs a
+     * single walk instead of a hole scan per file. compaction is not
+     * attempted for batch members; under BUDDY every allocation is already
+     * O(log N) and the batch simply loops.
+     *
+     * @param files name/size pairs to create.
+     * @return int - number of files actually created.
      */
-    int read(string filename, int size, int offset = 0){
-        int block_access = 1;
-
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "LinkedFileSystem::read() : File " << filename << " not found\n";
-            return block_access;
+    int create_batch(const vector<pair<string, int>>& files){
+        // the planned pass below bypasses create(), so the metadata cap is
+        // checked once for the whole batch.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "ContiguousFileSystem::create_batch() : metadata budget exceeded\n";
+            return 0;
+        }
+        size_t before = file_map.size();
+        if(strategy == BUDDY){
+            for(auto& f : files)
+                create(f.first, f.second);
+            return file_map.size() - before;
         }
 
-        File* fp = file_map[filename];
-        block* start = fp->start_block;
-
-        int bno = 0, read = 0;
+        StatsTimer _t(stats.create_ns);
+        multiset<pair<int, size_t>> pending;  // (size, request index)
+        unordered_set<string_view> seen;
+        for(size_t i = 0; i < files.size(); i++){
+            if(file_map.find(files[i].first) || !seen.insert(files[i].first).second){
+                cerr << "ContigousFileSystem::create() : Filename " << files[i].first << " already taken\n";
+                continue;
+            }
+            // zero-size files own no extent : record them straight away,
+            // the hole walk has nothing to place for them.
+            if(files[i].second <= 0){
+                if constexpr (fs_stats_enabled)
+                    stats.creates++;
+                File* fp = alloc_file(0, -1);
+                fp->name = files[i].first;
+                file_map.insert(files[i].first, fp);
+                continue;
+            }
+            pending.insert({files[i].second, i});
+        }
 
-        //iterate through the list and read the blocks greater than offset.
-        while(start != nullptr && read < size){
-            if(bno >= offset){
-                read++;
-                cout << "LinkedFileSystem::read() : Reading block " << start->id << endl;
+        // one walk : placements are decided against a snapshot of the holes,
+        // applied afterwards, so the map mutating below never invalidates it.
+        vector<int> placed_at(files.size(), -1);
+        vector<pair<int, int>> runs(holes.begin(), holes.end());
+        for(auto& run : runs){
+            int start = run.first, len = run.second;
+            while(!pending.empty()){
+                auto it = pending.upper_bound({len, SIZE_MAX});
+                if(it == pending.begin())
+                    break;
+                --it;
+                placed_at[it->second] = start;
+                start += it->first;
+                len -= it->first;
+                pending.erase(it);
             }
-            bno++;
-            start = start->next;
-            block_access++;
+            if(pending.empty())
+                break;
         }
 
-        cout << "LinkedFileSystem::read() : Total blocks read : " << read << endl;
+        for(auto& miss : pending)
+            cerr << "ContiguousFileSystem::create() : Cannot allocate " << miss.first
+                 << " blocks for " << files[miss.second].first << endl;
+
+        for(size_t i = 0; i < files.size(); i++){
+            if(placed_at[i] == -1)
+                continue;
+            if constexpr (fs_stats_enabled)
+                stats.creates++;
+            allocate_extent(placed_at[i], files[i].second);
+            File* fp = alloc_file(files[i].second, placed_at[i]);
+            fp->name = files[i].first;
+            used_memory += files[i].second;
+            file_map.insert(files[i].first, fp);
+            files_by_start[placed_at[i]] = fp;
+            if(fs_summary(verbosity))
+                cout << "ContiguousFileSystem::create() : File " << files[i].first
+                     << " created with starting block - " << placed_at[i] << endl;
+        }
+        return file_map.size() - before;
+    }
 
-        return block_access;
+    /**
+     * @brief deletes a batch of files in one call.
+     *
+     * freeing an extent already coalesces into the hole maps in O(log H),
+     * so the batch applies the deletes in order; its value is pairing with
+     * create_batch and taking the concurrent wrapper's locks once.
+     *
+     * @param filenames files to delete.
+     * @return int - number of files deleted.
+     */
+    int delete_batch(const vector<string>& filenames){
+        size_t before = file_map.size();
+        for(auto& name : filenames)
+            delete_file(name);
+        return before - file_map.size();
     }
 
     /**
-     * @brief writes 'size' blocks starting from the given offset.
-     * 
+     * @brief resolves a filename to a small integer handle for the hot-path overloads.
+     *
+     * The handle stays valid until the file is deleted; opening the same file
+     * again returns the same handle.
+     *
      * @param filename name of the file.
-     * @param size number of blocks to write.
-     * @param offset starting block to write from.
-     * @return int - number of block accesses taken to write the file
+     * @return int - file handle, -1 if the file does not exist.
      */
-    int write(string filename, int size, int offset = 0){
-        int block_access = 1;
+    int open_file(const string& filename){
+        File* fp = file_map.find(filename);
+        if(!fp)
+            return -1;
+        if(fp->handle == -1){
+            fp->handle = handles.size();
+            handles.push_back(fp);
+        }
+        return fp->handle;
+    }
 
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "LinkedFileSystem::write() : File " << filename << " not found\n";
-            return block_access;
+    /**
+     * @brief reads 'size' blocks of the file from given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to read.
+     * @param offset block number to start reading.
+     * @return int - number of block accesses taken to read the file.
+     */
+    int read(string filename, int size=-1, int offset = 0) {
+        //if file is not present in the filesytem, return.
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ContiguousFileSystem:read() : File " << filename << " not found\n";
+            return 1;
         }
-        
-        File* fp = file_map[filename];
+        return read_file(fp, size, offset);
+    }
 
-        // if the required number of overflow blocks is greater than the size of the free list, return.
-        if(offset + size > fp->filesize && offset + size - fp->filesize  > free_list.size()){
-            cerr << "LinkedFileSystem::write() : cannot allocate memory for write\n";
-            return block_access;
+    /**
+     * @brief reads by file handle, skipping the name lookup.
+     */
+    int read(int fd, int size=-1, int offset = 0) {
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ContiguousFileSystem:read() : bad file handle " << fd << "\n";
+            return 1;
         }
+        return read_file(fp, size, offset);
+    }
 
-        block *curr = fp->start_block, *prev = nullptr;
-        
-        int bno = 0, written = 0;
+    private:
 
-        //iterate through the list overwrite if block number greater than offset. allocate overflow blocks as when required.
-        while(written != size){
-            if(!curr){
-                curr = prev->next = free_list.front();
-                free_list.pop_front();
-                cout << "LinkedFileSystem::write() : Allocating new block " << curr->id << endl; 
-                fp->filesize++;
-                used_memory++;
-            }
+    int read_file(File* fp, int size, int offset) {
+        int block_access = 1;
 
-            if(bno >= offset){
-                cout << "LinkedFileSystem::write() : writing block " << curr->id << endl;
-                written++;
-            }
+        size = (size==-1) ? fp->filesize : size;
 
-            bno++;
-            prev = curr;
-            curr = curr->next;
-            block_access++;
-        }
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
 
-        clock_t end_time = clock();
+        // contiguous layout : seek straight to the offset and read from there.
+        int read = 0;
+        for(int i = offset; i < fp->filesize && read < size; i++){
+            int b = fp->start_block + i;
+            if(fs_trace(verbosity))
+                cout << "ContiguousFileSystem:read() : Reading block " << b << endl;
+            bool hit = cache && cache->access(b);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, b, hit);
+            read++;
+        }
 
-        cout << "LinkedFileSystem::write() : Total blocks written : " << written << endl;
+        if(fs_summary(verbosity))
+            cout << "ContiguousFileSystem:read() : Total blocks read : " << read << endl;
 
+        last_io = io;
         return block_access;
     }
 
+    public:
+
     /**
      * @brief removes the given file from the filesystem.
-     * 
+     *
      * @param filename name of the file.
      */
     void delete_file(string filename){
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "LinkedFileSystem::delete() : File not found.\n";
+        //if file is not present in the filesytem, return.
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ContigousFileSystem::delete(): File not found.\n";
             return;
         }
+        delete_fp(fp);
+    }
 
-        File *fp = file_map[filename];
-        block *curr = fp->start_block;
-
-        cout << "LinkedFileSystem::delete() : deallocating file blocks\n";
-
-        //delink the blocks from the file and add it to free list.
-        while(curr){
-            block* next = curr->next;
-            curr->next = nullptr;
-            free_list.push_back(curr);
-            curr = next;
+    /**
+     * @brief deletes by file handle, skipping the name lookup.
+     */
+    void delete_file(int fd){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ContigousFileSystem::delete(): bad file handle " << fd << "\n";
+            return;
         }
+        delete_fp(fp);
+    }
 
-        used_memory -= fp->filesize;
-        file_map.erase(filename);
-        delete fp;
-
-        cout << "LinkedFileSystem::delete() : " << filename << " deleted\n";
+    /**
+     * @brief deletes every file under the given directory in one pass.
+     *
+     * the subtree is unlinked from the namespace once and each file's
+     * resources are then reaped, so the cost is O(files under dirname)
+     * rather than a scan of the whole namespace.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return int - number of files deleted.
+     */
+    int delete_tree(string dirname){
+        int removed = file_map.erase_under(dirname, [&](File* fp){ drop_file(fp); });
+        if(fs_summary(verbosity))
+            cout << "ContiguousFileSystem::delete_tree() : " << removed << " files deleted under " << dirname << endl;
+        return removed;
     }
 
     /**
-     * @brief Get the storage efficiency of the file system.
-     * 
-     * @return float - returns the ratio of used memory to the total memory size.
+     * @brief full names of every file under the given directory.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return vector<string> - the files' full paths.
      */
-    float get_storage_efficiency(){
-        return (float)used_memory/N;
+    vector<string> list_dir(string dirname){
+        vector<string> out;
+        file_map.for_each_under(dirname, [&](File* fp){ out.push_back(fp->name); });
+        return out;
     }
-};
 
-/**
- * @brief A file system which allocates non contiguous blocks to each file. the block numbers are stored in the metafile.
- * 
- * @tparam N size of the memory.
- */
-template<size_t N = 1024>
-class IndexedFileSystem{
     private:
-    class File {
-        int filesize;
-        vector<int> block_indices;
-        File(int filesize) : filesize(filesize) {}
-        friend class IndexedFileSystem;
-    };
 
-    unordered_map<string, File*> file_map;
-    list<int> free_list;
-    int used_memory;
+    // namespace removal and resource teardown are separate so the
+    // subtree delete can unlink a whole directory once and reap per file.
+    void delete_fp(File* fp){
+        file_map.erase(fp->name);
+        drop_file(fp);
+    }
+
+    void drop_file(File* fp){
+        StatsTimer _t(stats.delete_ns);
+        if constexpr (fs_stats_enabled)
+            stats.deletes++;
+        // mark the blocks as available.
+        if(fs_summary(verbosity))
+            cout << "ContiguousFileSystem::delete_file() : deallocating blocks\n";
+        // zero-size files own no extent and have nothing to free.
+        if(fp->start_block != -1){
+            int span = alloc_span(fp->filesize);
+            free_extent(fp->start_block, span);
+            // growth never leaves the chunk, so order_for(filesize) is still the
+            // order that create() took.
+            if(strategy == BUDDY)
+                buddy_release(fp->start_block, order_for(fp->filesize));
+            used_memory -= span;
+            files_by_start.erase(fp->start_block);
+        }
+
+        // delete metafile and drop the handle, if any.
+        if(fp->handle != -1)
+            handles[fp->handle] = nullptr;
+        if(fs_summary(verbosity))
+            cout << "ContiguousFileSystem::delete_file() : " <<  fp->name << " deleted\n";
+        release_file(fp);
+    }
 
     public:
+
     /**
-     * @brief Construct a new Indexed File System object
-     * 
+     * @brief writes 'size' blocks starting from the given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to write.
+     * @param offset starting block to write from.
+     * @return int - number of block accesses taken to write the file
      */
-    IndexedFileSystem() : used_memory(0){
-        for(int i = 0; i < N; i++)
-            free_list.push_back(i);
+    int write(string filename, int size, int offset = 0){
+        //if file is not present in the filesytem, return.
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ContigousFileSystem::write() : File " << filename << " not found\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
     }
 
     /**
-     * @brief Creates a file of given size. Allocates non contiguous blocks of memory.
-     * 
-     * @param filename name of the file.
-     * @param filesize size of the file.
+     * @brief writes by file handle, skipping the name lookup.
      */
-    void create(string filename, int size){
-        if(file_map.find(filename) != file_map.end()){
-            cerr << "IndexedFileSystem::create() : Filename already taken\n";
-            return;
+    int write(int fd, int size, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ContigousFileSystem::write() : bad file handle " << fd << "\n";
+            return 1;
         }
+        return write_file(fp, size, offset);
+    }
 
-        // if more blocks are required than it is available, return.
-        if(free_list.size() < size){
-            cerr << "IndexedFileSystem::create() : cannot allocate " << size << " blocks for " << filename << "\n";
-            return;
-        }
+    private:
 
-        File* fp = new File(size);
+    int write_file(File* fp, int size, int offset){
+        int block_access = 1;
 
-        //remove blocks from free list and add it to the list of indices.
-        for(int i = 0; i < size; i++){
-            fp->block_indices.push_back(free_list.front());
-            free_list.pop_front();
-        }
+        if(size + offset > fp->filesize){
+            // in case of overflow, check if contiguous blocks can be allotted.
+            int req = size + offset - fp->filesize;
 
-        used_memory += size;
-        file_map[filename] = fp;
-        cout << "IndexedFileSystem::create() : file " << filename << " created starting block " << fp->block_indices[0] << endl;
-    }
+            if(fp->start_block == -1){
+                // a zero-size file has no extent yet : growth places a fresh
+                // one just like create would.
+                int span = alloc_span(req);
+                int start = get_index(req);
+                if(start == -1){
+                    cerr << "ContiguousFileSystem::write() : Blocks for given size cannot be allocated.\n";
+                    return block_access;
+                }
+                allocate_extent(start, span);
+                fp->start_block = start;
+                fp->filesize = req;
+                used_memory += span;
+                files_by_start[start] = fp;
+            }
+            else if(strategy == BUDDY){
+                // the chunk is already rounded up to a power of two, so the
+                // padding past the file is reserved slack growth may claim :
+                // those blocks are marked used and counted in used_memory.
+                // growing past the chunk would need its (possibly taken)
+                // buddy, so that is refused rather than splitting chunks
+                // off their alignment.
+                if(size + offset > alloc_span(fp->filesize)){
+                    cerr << "ContiguousFileSystem::write() : cannot grow past the file's buddy chunk.\n";
+                    return block_access;
+                }
+                fp->filesize = size + offset;
+            }
+            else{
+                int end = fp->start_block + fp->filesize;
+
+                // the blocks right after the file are free iff a hole starts exactly at 'end'.
+                auto hole = holes.find(end);
+                if(hole == holes.end() || hole->second < req){
+                    cerr << "ContiguousFileSystem::write() : Blocks for given size cannot be allocated.\n";
+                    return block_access;
+                }
 
-    /**
-     * @brief reads 'size' blocks of the file from given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to read.
-     * @param offset block number to start reading.
-     * @return int - number of block accesses taken to read the file.
-     */
-    int read(string filename, int size = -1, int offset = 0){
-        int block_access = 1;
+                //if it is possible to allot contiguous blocks, mark them as used.
+                allocate_extent(end, req);
 
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "IndexedAllocation::read() : File " << filename << " not found\n";
-            return block_access;
-        }
+                fp->filesize += req;
 
-        File* fp = file_map[filename];
+                used_memory += req;
+            }
+        }
 
-        size = (size == -1) ? fp->filesize : size;
-        int read = 0;
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
 
-        // iterate through the list of indices from the offset.
-        for(int i = offset; i < fp->filesize && read < size; i++){
-            cout << "IndexedAllocation::read() : Reading block " << fp->block_indices[i] << endl;
-            read++;
-            block_access++;
+        int start = fp->start_block + offset;
+        for(int i = 0; i < size; i++){
+            bool hit = cache && cache->access(start + i);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, start + i, hit);
+            if(fs_trace(verbosity))
+                cout << "ContigousFileSystem::write() : Writing block " <<  start + i << endl;
         }
 
-        cout << "IndexedAllocation::read() : Total blocks read : " << read << endl;
-
+        if(fs_summary(verbosity))
+            cout << "ContigousFileSystem::write() : Total blocks written " << size << endl;
+        last_io = io;
         return block_access;
     }
 
+    public:
+
     /**
-     * @brief writes 'size' blocks starting from the given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to write.
-     * @param offset starting block to write from.
-     * @return int - number of block accesses taken to write the file
+     * @brief Get the storage efficiency of the file system.
+     *
+     * @return float - returns the ratio of used memory to the total memory size.
      */
-    int write(string filename, int size, int offset = 0){
-        int block_access = 1;
-
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "IndexedFileSystem::write() : File " << filename << " not found\n";
-            return block_access;
-        }
-
-        File* fp = file_map[filename];
-        int written = 0;
-        int bno = offset;
-
-        // if more overflow blocks are required than it is available, return.
-        if(offset + size > fp->filesize && offset + size - fp->filesize  > free_list.size()){
-            cerr << "IndexedFileSystem::write() : cannot allocate memory for write\n";
-            return block_access;
-        }
-
-        // allocate new blocks from free list if required.
-        while(written < size){
-            if(bno >= fp->block_indices.size()){
-                fp->block_indices.push_back(free_list.front());
-                cout << "IndexedFileSystem::write() : Allocating new block " << free_list.front() << endl;
-                free_list.pop_front();
-                fp->filesize++;
-                used_memory++;
-            }
-            
-            cout << "IndexedFileSystem::write() : Writing block " << fp->block_indices[bno] << endl;
-            block_access++;
-            written++;
-            bno++;
-        }
+    float get_storage_efficiency(){
+        //cout << "used memory : " << used_memory << endl;
+        return (float)used_memory/N;
+    }
 
-        cout << "IndexedFileSystem::write() : Total blocks written : " << written << endl;
+    /**
+     * @brief estimated host-heap bytes behind this instance, by structure.
+     *
+     * the bitmap and its summary tree dominate empty instances, the hole
+     * index and name map grow with live files.
+     */
+    MemoryFootprint get_memory_footprint(){
+        MemoryFootprint f;
+        f.block_store = store.capacity() + sizeof(memory_map) + vec_heap_bytes(summary);
+        f.file_records = deque_heap_bytes(slab) + vec_heap_bytes(slab_free);
+        for(const File& rec : slab)
+            f.file_records += string_heap_bytes(rec.name);
+        f.free_lists = map_heap_bytes(holes) + set_heap_bytes(holes_by_size) + vec_heap_bytes(buddy_free);
+        for(auto& bucket : buddy_free)
+            f.free_lists += hash_heap_bytes(bucket);
+        f.name_map = file_map.footprint() + vec_heap_bytes(handles) + map_heap_bytes(files_by_start);
+        if(f.total() > mem_high_water)
+            mem_high_water = f.total();
+        return f;
+    }
 
-        return block_access;
+    /**
+     * @brief bounded-metadata mode : creates fail once the footprint
+     * passes the budget. 0 (the default) lifts the cap.
+     */
+    void set_metadata_budget(size_t bytes){
+        metadata_budget = bytes;
     }
 
     /**
-     * @brief removes the given file from the filesystem.
-     * 
-     * @param filename name of the file.
+     * @brief largest footprint total observed so far; refreshed here and
+     * by every budget check and get_memory_footprint() call.
      */
-    void delete_file(string filename){
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "IndexedFleSystem::delete() : File not found.\n";
-            return;
-        }
-        File *fp = file_map[filename];
+    size_t get_metadata_high_water(){
+        get_memory_footprint();
+        return mem_high_water;
+    }
 
-        // remove the block index from index table and add it to free list.
-        cout << "IndexedFleSystem::delete() : deallocating file blocks\n";
-        for(int blocks : fp->block_indices)
-            free_list.push_back(blocks);
-        
-        used_memory -= fp->filesize;
-        delete fp;
-        file_map.erase(filename);
-        cout << "IndexedFleSystem::delete() : File " << filename << " deleted\n";
+    /**
+     * @brief fragmentation picture of the free space, in O(1).
+     *
+     * the hole index is updated on every extent allocation and free, so
+     * this is a read of maintained state, not a memory_map scan - adaptive
+     * policies and dashboards can sample it per operation.
+     */
+    FragmentationStats get_fragmentation_stats(){
+        FragmentationStats fr;
+        fr.hole_count = holes.size();
+        fr.free_blocks = memory_size - used_memory;
+        if(!holes_by_size.empty())
+            fr.largest_hole = std::prev(holes_by_size.end())->first;
+        if(fr.hole_count > 0)
+            fr.mean_hole = (float)fr.free_blocks / fr.hole_count;
+        if(fr.free_blocks > 0)
+            fr.external_frag = 1.0f - (float)fr.largest_hole / fr.free_blocks;
+        return fr;
     }
 
     /**
-     * @brief Get the storage efficiency of the file system.
-     * 
-     * @return float - returns the ratio of used memory to the total memory size.
+     * @brief sets how much this filesystem logs.
+     *
+     * @param v QUIET/SUMMARY/TRACE.
      */
-    float get_storage_efficiency(){
-        return (float)used_memory/N;
+    void set_verbosity(Verbosity v){
+        verbosity = v;
     }
 
-};
+    /**
+     * @brief puts a buffer cache in front of this filesystem's block accesses.
+     *
+     * @param c the cache, may be shared with other filesystems. nullptr detaches.
+     */
+    void attach_cache(BufferCache* c){
+        cache = c;
+    }
 
-/**
- * @brief A file system that allocates initial contiguous block. contiguous overflow blocks are linked. Inherits from ContiguousFileSystem
- * 
- * @tparam N size of the memory
- */
-template<size_t N=1024>
-class ModifiedContiguousFileSystem : public ContiguousFileSystem<N>{
-    private:
-    struct block{
-        int start_block;
-        int size;
-        block* next;
-        block(int strt, int sz, block* nxt = nullptr){
-            start_block = strt;
-            size = sz;
-            next = nxt;
-        }
-    };
-    class File{
-        int filesize;
-        block* start;
-        File(int filesize, block* start) : filesize(filesize), start(start) {}
-        friend class ModifiedContiguousFileSystem;
-    };
+    /**
+     * @brief instrumentation counters, with the live hole count filled in.
+     *
+     * all counters read zero when stats are compiled out with -DFS_NO_STATS.
+     */
+    FsStats get_stats(){
+        stats.free_runs = holes.size();
+        return stats;
+    }
 
-    unordered_map<string, File*> file_map;
+    /**
+     * @brief replaces the cost model used to charge block touches.
+     */
+    void set_cost_model(CostModel m){
+        cost_model = m;
+    }
 
-    public: 
-    ModifiedContiguousFileSystem(typename ContiguousFileSystem<N>::Strategy alg = ContiguousFileSystem<N> :: FIRST_FIT) : ContiguousFileSystem<N>(alg){}
+    /**
+     * @brief blocks moved and modeled cost of the most recent read/write.
+     */
+    IoResult get_last_io(){
+        return last_io;
+    }
 
     /**
-     * @brief Creates a file of given size. Allocates contiguous linked blocks of memory.
-     * 
+     * @brief returns zero-copy views over the file's bytes in [offset, offset+len).
+     *
      * @param filename name of the file.
-     * @param filesize size of the file.
+     * @param len number of bytes, -1 for everything from the offset on.
+     * @param offset starting byte within the file.
+     * @return views into the backing store, empty on error.
      */
-    void create(string filename, int filesize) {
-        if(file_map.find(filename) != file_map.end()){
-            cerr << "ModifiedContiguousFileSystem::create() : Filename already taken\n";
-            return;
+    vector<BlockView> map_file(string filename, int len = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ContigousFileSystem::map_file() : File " << filename << " not found\n";
+            return {};
         }
+        return map_views(fp, len, offset);
+    }
 
-        // get the start index of allotted chunk.
-        int start = this->get_index(filesize);
+    /**
+     * @brief copies the file's bytes in [offset, offset+len) into buf.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int read(string filename, char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return gather_bytes(views, buf);
+    }
 
-        // if it is not possible to allot contiguous chunk return.
-        if(start == -1){
-            cerr << "ModifiedContiguousFileSystem::create() : Can't allocate " << filesize << " blocks for file " << filename << "\n";
-            return;
-        }
+    /**
+     * @brief copies len bytes of buf into the file at the given byte offset.
+     *
+     * the write must fit inside the file's allocated blocks; the data plane
+     * never grows a file.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int write(string filename, const char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return scatter_bytes(views, buf);
+    }
 
-        cout << "ModifiedContiguousFileSystem::create() : File created starting block - " << start << endl;
+    private:
 
-        // mark the allotted blocks as used.
-        for(int i = 0; i < filesize; i++){
-            this->memory_map.set(i+start);
+    /**
+     * @brief clips a byte range against the file and builds its view list.
+     */
+    vector<BlockView> map_views(File* fp, int len, int offset){
+        int limit = fp->filesize * (int)FS_BLOCK_SIZE;
+        if(len == -1)
+            len = limit - offset;
+        if(offset < 0 || len < 0 || offset + len > limit){
+            cerr << "ContigousFileSystem::map_file() : byte range past end of file\n";
+            return {};
         }
-
-        this->used_memory += filesize;
-        File* fp = new File(filesize, new block(start, filesize));
-        file_map[filename] = fp;
-        return;
+        if(len == 0)
+            return {};
+        return runs_to_views(store_base(), {{fp->start_block, fp->filesize}}, offset, len);
     }
 
+    public:
+
     /**
-     * @brief writes 'size' blocks starting from the given offset. contiguous blocks are alloted and linked to the file.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to write.
-     * @param offset starting block to write from.
-     * @return int - number of block accesses taken to write the file
+     * @brief incrementally compacts files towards the start of memory.
+     *
+     * Each step moves the file sitting right after the lowest hole down onto
+     * it, coalescing the hole towards the end of memory. The walk stops once
+     * moving the next file would exceed the budget, so a huge map can be
+     * compacted across many small calls instead of one stop-the-world sweep.
+     *
+     * @param max_blocks_to_move budget of block moves for this call.
+     * @return int - number of blocks actually moved.
      */
-    int write(string filename, int size, int offset) {
-        int block_access = 1;
-
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "ModifiedContiguousFileSystem::write() : File " << filename << " not found\n";
+    int defragment(int max_blocks_to_move){
+        // buddy chunks must stay aligned to their size; nothing to compact.
+        if(strategy == BUDDY)
             return 0;
+        int moved = 0;
+
+        while(moved < max_blocks_to_move && !holes.empty()){
+            auto h = holes.begin();
+            int hole_start = h->first;
+            int pos = hole_start + h->second;
+
+            // nothing after the lowest hole : memory is fully compacted.
+            auto it = files_by_start.find(pos);
+            if(it == files_by_start.end())
+                break;
+
+            File* fp = it->second;
+            if(moved + fp->filesize > max_blocks_to_move)
+                break;
+
+            // slide the file down onto the hole, data plane included. the
+            // ranges can overlap, hence memmove.
+            if(!store.empty())
+                memmove(store.data() + (size_t)hole_start * FS_BLOCK_SIZE,
+                        store.data() + (size_t)fp->start_block * FS_BLOCK_SIZE,
+                        (size_t)fp->filesize * FS_BLOCK_SIZE);
+            free_extent(fp->start_block, fp->filesize);
+            allocate_extent(hole_start, fp->filesize);
+            files_by_start.erase(it);
+            fp->start_block = hole_start;
+            files_by_start[hole_start] = fp;
+
+            moved += fp->filesize;
         }
 
-        File* fp = file_map[filename];
-        block* newblock = nullptr;
-        if(size + offset > fp->filesize){
-            // check if a contiguous chunk can be allotted for the overflow data. 
-            int req = size + offset - fp->filesize;
-            int available;
-
-            int index = this->get_index(req);
-
-            // if possible, mark the blocks as used.
-            for(int i = 0; i < req; i++){
-                this->memory_map.set(i+index);
-            }
+        blocks_moved += moved;
+        return moved;
+    }
 
-            if(index == -1){
-                cerr << "ModifiedContiguousFileSystem::write() : cannot allocate overflow blocks\n";
-                return block_access;
-            }
-            
-            newblock = new block(index, req);
+    /**
+     * @brief enables or disables automatic compaction when an allocation fails.
+     */
+    void set_auto_defrag(bool enable){
+        auto_defrag = enable;
+    }
 
-            fp->filesize += req; 
+    /**
+     * @brief Get the total number of blocks relocated by defragmentation.
+     *
+     * @return int - cumulative blocks-moved cost.
+     */
+    int get_blocks_moved(){
+        return blocks_moved;
+    }
 
-            this->used_memory += req;
+    /**
+     * @brief writes the filesystem metadata to a flat binary snapshot.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool save_snapshot(const string& path){
+        ofstream out(path, ios::binary);
+        if(!out){
+            cerr << "ContiguousFileSystem::save_snapshot() : cannot open " << path << "\n";
+            return false;
         }
+        out.write(SNAP_MAGIC, sizeof(SNAP_MAGIC));
+        out.put('C');
+        save_core(out);
+        uint32_t nfiles = file_map.size();
+        snap_put(out, nfiles);
+        file_map.for_each([&](File* fp){
+            snap_put_str(out, fp->name);
+            snap_put(out, fp->filesize);
+            snap_put(out, fp->start_block);
+        });
+        return out.good();
+    }
 
-        int bno = 0, written = 0;
-        block* b = fp->start;
-        block* last = nullptr;
-
-        while(b && written < size){
-            block_access++;
-            if(offset >= bno && offset < bno + b->size){
-                int wrt = offset-bno;
-                if(wrt == 0)
-                    block_access--;
-                for(int i = wrt; i < b->size && written != size; i++){
-                    cout << "ModifiedContiguousFileSystem::write() : Writing block " << b->start_block + i << endl;
-                    block_access++;
-                    written++;
-                }
-                offset += written;
-            }
-            bno += b->size;
-            last = b;
-            b = b->next;
+    /**
+     * @brief restores the filesystem metadata from a snapshot, replacing all state.
+     *
+     * The snapshot is memory-mapped and decoded with bulk reads; open handles
+     * do not survive a load.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool load_snapshot(const string& path){
+        size_t len;
+        const char* p;
+        const char* base = snap_map(path.c_str(), 'C', len, p);
+        if(!base){
+            cerr << "ContiguousFileSystem::load_snapshot() : cannot load " << path << "\n";
+            return false;
         }
-
-        if(newblock){
-            cout << "ModifiedContiguousFileSystem::write() : Allocating overflow blocks\n" ;
-            for(int i = 0; i < newblock->size; i++){
-                cout << "ModifiedContiguousFileSystem::write() : Writing block " << newblock->start_block + i << endl;
-                block_access++;
-                written++;
+        const char* e = base + len;
+
+        reset_files();
+        bool ok = load_core(p, e);
+
+        uint32_t nfiles = 0;
+        ok = ok && snap_get(p, e, nfiles);
+        for(uint32_t i = 0; ok && i < nfiles; i++){
+            string fname;
+            int fsz = 0, sb = 0;
+            ok = snap_get_str(p, e, fname) && snap_get(p, e, fsz) && snap_get(p, e, sb)
+              && (sb == -1 ? fsz == 0 : snap_range_ok(sb, fsz, N));
+            if(ok){
+                File* fp = alloc_file(fsz, sb);
+                fp->name = fname;
+                file_map.insert(fname, fp);
+                if(sb != -1)
+                    files_by_start[sb] = fp;
             }
-            last->next = newblock;
         }
 
-        cout << "ModifiedContiguousFileSystem::write() : Total blocks written : " << written << endl;
-
-        return size+1;
+        munmap((void*)base, len);
+        if(!ok)
+            cerr << "ContiguousFileSystem::load_snapshot() : snapshot " << path << " is corrupt\n";
+        return ok;
     }
 
+    protected:
+
     /**
-     * @brief reads 'size' blocks of the file from given offset.
-     * 
-     * @param filename name of the file.
-     * @param size number of blocks to read.
-     * @param offset block number to start reading.
-     * @return int - number of block accesses taken to read the file.
+     * @brief serializes the allocator state shared with derived classes.
      */
-    int read(string filename, int size=-1, int offset = 0) {
-        int block_access = 1;
+    void save_core(ofstream& out){
+        uint64_t n = N;
+        snap_put(out, n);
+        snap_put(out, used_memory);
+        snap_put(out, start_index);
+        out.write((const char*)&memory_map, sizeof(memory_map));
+        uint32_t nholes = holes.size();
+        snap_put(out, nholes);
+        for(auto& h : holes){
+            snap_put(out, h.first);
+            snap_put(out, h.second);
+        }
+    }
 
-        if(file_map.find(filename) == file_map.end()){
-            cerr << "ModifiedContigousFileSystem::read() : File " << filename << " not found\n";
-            return block_access;
+    /**
+     * @brief restores the allocator state written by save_core.
+     */
+    bool load_core(const char*& p, const char* e){
+        uint64_t n;
+        if(!snap_get(p, e, n) || n != N)
+            return false;
+        if(!snap_get(p, e, used_memory) || !snap_get(p, e, start_index))
+            return false;
+        if(!snap_range_ok(0, used_memory, N) || !snap_range_ok(start_index, 0, N))
+            return false;
+        if(p + sizeof(memory_map) > e)
+            return false;
+        memcpy(&memory_map, p, sizeof(memory_map));
+        p += sizeof(memory_map);
+        build_summary();
+
+        holes.clear();
+        holes_by_size.clear();
+        uint32_t nholes;
+        if(!snap_get(p, e, nholes))
+            return false;
+        for(uint32_t i = 0; i < nholes; i++){
+            int start, hlen;
+            if(!snap_get(p, e, start) || !snap_get(p, e, hlen))
+                return false;
+            // holes feed mask_range's memcpy offsets later : bad ranges
+            // from a forged snapshot must not get into the index.
+            if(hlen <= 0 || !snap_range_ok(start, hlen, N))
+                return false;
+            holes[start] = hlen;
+            holes_by_size.insert({hlen, start});
         }
-        
-        File* fp = file_map[filename];
+        if(strategy == BUDDY)
+            buddy_rebuild();
+        return true;
+    }
 
-        size = (size==-1) ? fp->filesize : size;
+    /**
+     * @brief drops all file metadata and open handles.
+     */
+    void reset_files(){
+        file_map.clear();
+        files_by_start.clear();
+        handles.clear();
+        slab.clear();
+        slab_free.clear();
+    }
 
-        int read = 0, bno = 0;
-        block* b = fp->start;
+    // slab of File records : stored by value in a deque so addresses stay
+    // stable for a record's whole life, with freed slots recycled through a
+    // freelist. no per-file new/delete, and teardown is just the deque dying.
+    deque<File> slab;
+    vector<File*> slab_free;
 
-        // find the block where the offset block is present and start reading.
-        while(b && read < size){
-            block_access++;
-            if(offset >= bno && offset < bno + b->size){
-                int rd = offset - bno;
-                if(rd == 0)
-                    block_access--;
-                for(int i = rd; i < b->size && read < size; i++){
-                    cout << "ModifiedContigousFileSystem::read() : Reading block " << b->start_block + i << endl;
-                    block_access++;
-                    read++;
-                }
-                offset += read;
-            }
-            bno += b->size;
-            b = b->next;
+    /**
+     * @brief takes a File record off the slab, reusing a freed slot if any.
+     */
+    File* alloc_file(int filesize, int start){
+        if(!slab_free.empty()){
+            File* fp = slab_free.back();
+            slab_free.pop_back();
+            *fp = File(filesize, start);
+            return fp;
         }
-
-        cout << "ModifiedContigousFileSystem::read() : Total blocks read : " << read << endl;
-
-        return size+1;
+        slab.push_back(File(filesize, start));
+        return &slab.back();
     }
 
     /**
-     * @brief removes the given file from the filesystem.
-     * 
-     * @param filename name of the file.
+     * @brief returns a dead File record's slot to the slab freelist.
+     */
+    void release_file(File* fp){
+        slab_free.push_back(fp);
+    }
+
+    /**
+     * @brief length of the largest hole, 0 when memory is full.
+     */
+    int largest_hole(){
+        if(holes_by_size.empty())
+            return 0;
+        return std::prev(holes_by_size.end())->first;
+    }
+
+    Verbosity verbosity = TRACE;
+    BufferCache* cache = nullptr;
+    FsStats stats;
+    CostModel cost_model;
+    AtomicIoResult last_io;
+    vector<char> store;  // data plane backing memory, sized lazily on first use.
+
+    size_t metadata_budget = 0;  // host bytes allowed for metadata, 0 = unbounded.
+    size_t mem_high_water = 0;   // largest footprint total seen so far.
+
+    /**
+     * @brief base of the backing store, allocating it on first touch.
+     *
+     * the store is never resized afterwards, so views into it stay valid.
+     */
+    char* store_base(){
+        if(store.empty())
+            store.resize(N * FS_BLOCK_SIZE);
+        return store.data();
+    }
+
+    bitset<N> memory_map;
+    DirTree<File> file_map;
+    map<int, File*> files_by_start;  // files ordered by start block, for compaction.
+    vector<File*> handles;  // open-handle table; slots of deleted files are nulled.
+    bool auto_defrag = false;
+    int blocks_moved = 0;
+
+    /**
+     * @brief resolves a handle back to its file, nullptr for stale or bad handles.
+     */
+    File* handle_file(int fd){
+        if(fd < 0 || fd >= (int)handles.size())
+            return nullptr;
+        return handles[fd];
+    }
+    const int memory_size;
+    int start_index;
+    Strategy strategy;
+
+    // BUDDY : free chunks bucketed by order. every chunk is aligned to its
+    // own size, so a chunk's buddy differs from it in exactly one address bit.
+    vector<unordered_set<int>> buddy_free;
+    int used_memory;
+
+    // free-extent index : every maximal run of free blocks (a hole) is kept both
+    // ordered by start and ordered by size, so hole queries don't rescan the bitmap.
+    map<int, int> holes;                    // start block -> hole length
+    multiset<pair<int, int>> holes_by_size; // (hole length, start block)
+
+    /**
+     * @brief adds a hole to the free-extent index, coalescing with adjacent holes.
+     *
+     * @param start starting block of the hole.
+     * @param len number of blocks in the hole.
+     */
+    void add_hole(int start, int len){
+        if(len <= 0)
+            return;
+
+        // coalesce with the hole ending right at 'start'.
+        auto next = holes.lower_bound(start);
+        if(next != holes.begin()){
+            auto prev = std::prev(next);
+            if(prev->first + prev->second == start){
+                start = prev->first;
+                len += prev->second;
+                holes_by_size.erase(holes_by_size.find({prev->second, prev->first}));
+                holes.erase(prev);
+            }
+        }
+
+        // coalesce with the hole starting right after the new hole.
+        if(next != holes.end() && start + len == next->first){
+            len += next->second;
+            holes_by_size.erase(holes_by_size.find({next->second, next->first}));
+            holes.erase(next);
+        }
+
+        holes[start] = len;
+        holes_by_size.insert({len, start});
+    }
+
+    // hierarchical bitmap summary : a segment tree over the 64-block words of
+    // memory_map. each node records the longest free run inside its span plus
+    // the free runs touching its edges, so "first hole of size K at or after
+    // index I" descends the tree instead of rescanning the bitmap, and range
+    // set/reset only refreshes the leaves whose words were masked.
+    struct Summary{
+        int max_run;  // longest free run fully inside the span.
+        int prefix;   // free run touching the left edge.
+        int suffix;   // free run touching the right edge.
+        int span;     // blocks covered, 0 for padding leaves past the bitmap.
+    };
+    static constexpr int SUMMARY_WORDS = (int)((N + 63) / 64);
+    vector<Summary> summary;  // 1-based heap layout, leaves cover one word each.
+    int summary_leaves;
+
+    /**
+     * @brief reads 64 bitmap bits as one word, via the raw bitset storage when
+     * its layout allows, bit by bit otherwise.
+     */
+    uint64_t word_at(int w){
+        if constexpr (sizeof(memory_map) >= (size_t)SUMMARY_WORDS * 8){
+            uint64_t word;
+            memcpy(&word, reinterpret_cast<const unsigned char*>(&memory_map) + (size_t)w * 8, 8);
+            return word;
+        }
+        else{
+            uint64_t word = 0;
+            for(int b = 0; b < 64 && w * 64 + b < (int)N; b++)
+                if(memory_map[w * 64 + b])
+                    word |= 1ULL << b;
+            return word;
+        }
+    }
+
+    /**
+     * @brief writes 64 bitmap bits back as one word.
+     */
+    void store_word(int w, uint64_t word){
+        if constexpr (sizeof(memory_map) >= (size_t)SUMMARY_WORDS * 8){
+            memcpy(reinterpret_cast<unsigned char*>(&memory_map) + (size_t)w * 8, &word, 8);
+        }
+        else{
+            for(int b = 0; b < 64 && w * 64 + b < (int)N; b++)
+                memory_map[w * 64 + b] = (word >> b) & 1;
+        }
+    }
+
+    /**
+     * @brief recomputes one leaf of the summary from its bitmap word.
+     */
+    void set_leaf(int w){
+        Summary& s = summary[summary_leaves + w];
+        if(w >= SUMMARY_WORDS){
+            s = {0, 0, 0, 0};
+            return;
+        }
+        uint64_t word = word_at(w);
+        // bits past N count as used so runs can't spill off the bitmap.
+        if(w == SUMMARY_WORDS - 1 && N % 64)
+            word |= ~((1ULL << (N % 64)) - 1);
+        word_zero_runs(word, s.max_run, s.prefix, s.suffix);
+        s.span = 64;
+    }
+
+    /**
+     * @brief combines two adjacent summaries, joining the runs at their seam.
+     */
+    static Summary merge_summary(const Summary& a, const Summary& b){
+        if(a.span == 0)
+            return b;
+        if(b.span == 0)
+            return a;
+        Summary s;
+        s.span = a.span + b.span;
+        s.prefix = (a.prefix == a.span) ? a.span + b.prefix : a.prefix;
+        s.suffix = (b.suffix == b.span) ? b.span + a.suffix : b.suffix;
+        s.max_run = max(max(a.max_run, b.max_run), a.suffix + b.prefix);
+        return s;
+    }
+
+    /**
+     * @brief rebuilds the whole summary tree from the bitmap.
+     */
+    void build_summary(){
+        summary_leaves = 1;
+        while(summary_leaves < SUMMARY_WORDS)
+            summary_leaves <<= 1;
+        summary.assign(2 * summary_leaves, {0, 0, 0, 0});
+        for(int w = 0; w < summary_leaves; w++)
+            set_leaf(w);
+        for(int i = summary_leaves - 1; i >= 1; i--)
+            summary[i] = merge_summary(summary[2 * i], summary[2 * i + 1]);
+    }
+
+    /**
+     * @brief refreshes leaves w0..w1 and pulls the change up to the root.
+     */
+    void update_summary(int w0, int w1){
+        for(int w = w0; w <= w1; w++)
+            set_leaf(w);
+        int lo = (summary_leaves + w0) >> 1, hi = (summary_leaves + w1) >> 1;
+        while(lo >= 1){
+            for(int i = lo; i <= hi; i++)
+                summary[i] = merge_summary(summary[2 * i], summary[2 * i + 1]);
+            lo >>= 1;
+            hi >>= 1;
+        }
+    }
+
+    /**
+     * @brief sets or clears a whole block range with word-sized masks.
+     *
+     * one masked store per 64 blocks instead of one bitset call per block,
+     * then a single O(log N) summary refresh for the touched leaves.
+     */
+    void mask_range(int start, int len, bool value){
+        int w0 = start / 64, w1 = (start + len - 1) / 64;
+        for(int w = w0; w <= w1; w++){
+            uint64_t mask = ~0ULL;
+            if(w == w0 && start % 64)
+                mask &= ~((1ULL << (start % 64)) - 1);
+            int endbit = start + len - w * 64;
+            if(endbit < 64)
+                mask &= (1ULL << endbit) - 1;
+            uint64_t word = word_at(w);
+            store_word(w, value ? (word | mask) : (word & ~mask));
+        }
+        update_summary(w0, w1);
+    }
+
+    /**
+     * @brief marks the given extent as used in the bitmap and carves it out of the free-extent index.
+     *
+     * @param start starting block of the extent.
+     * @param len number of blocks in the extent.
+     */
+    void allocate_extent(int start, int len){
+        mask_range(start, len, true);
+
+        // find the hole containing 'start' and split it around the extent.
+        auto it = holes.upper_bound(start);
+        --it;
+        int hole_start = it->first, hole_len = it->second;
+        holes_by_size.erase(holes_by_size.find({hole_len, hole_start}));
+        holes.erase(it);
+
+        if(hole_start < start)
+            add_hole(hole_start, start - hole_start);
+        if(start + len < hole_start + hole_len)
+            add_hole(start + len, hole_start + hole_len - (start + len));
+    }
+
+    /**
+     * @brief marks the given extent as free in the bitmap and returns it to the free-extent index.
+     *
+     * @param start starting block of the extent.
+     * @param len number of blocks in the extent.
+     */
+    void free_extent(int start, int len){
+        mask_range(start, len, false);
+        add_hole(start, len);
+    }
+
+    /**
+     * @brief finds a run of 'size' free blocks starting at or after 'from'.
+     *
+     * Descends the bitmap summary tree : subtrees whose max free run is too
+     * short are skipped wholesale on the strength of their summary alone, so
+     * the query touches O(log N) nodes plus the few words a candidate run
+     * actually crosses.
+     *
+     * @param from block index to start scanning from.
+     * @param size length of the free run to find.
+     * @return int - starting block of the first such run, -1 if none.
+     */
+    int scan_zero_run(int from, int size){
+        int carry = 0;
+        long long steps_before = stats.scan_steps;
+        int found = scan_node(1, 0, summary_leaves * 64, from, size, carry);
+        if constexpr (fs_stats_enabled)
+            stats.last_scan_steps = stats.scan_steps - steps_before;
+        return found;
+    }
+
+    /**
+     * @brief recursive workhorse of scan_zero_run over the node's range [lo, hi).
+     *
+     * @param carry free run ending at 'lo' (all of it at or after 'from');
+     * updated to the free run ending at 'hi' when nothing is found.
+     */
+    int scan_node(int node, int lo, int hi, int from, int size, int& carry){
+        if constexpr (fs_stats_enabled)
+            stats.scan_steps++;
+        // wholly before the scan origin or past the bitmap : contributes nothing.
+        if(hi <= from)
+            return -1;
+        const Summary& s = summary[node];
+        if(s.span == 0){
+            carry = 0;
+            return -1;
+        }
+
+        if(lo >= from){
+            // run spilling over from the left closes against this prefix.
+            if(carry + s.prefix >= size)
+                return lo - carry;
+            // nothing long enough anywhere inside : summarize and move on.
+            if(s.max_run < size){
+                carry = (s.prefix == s.span) ? carry + s.span : s.suffix;
+                return -1;
+            }
+        }
+
+        if(node >= summary_leaves)
+            return scan_leaf(node - summary_leaves, from, size, carry);
+
+        int mid = (lo + hi) / 2;
+        int found = scan_node(2 * node, lo, mid, from, size, carry);
+        if(found != -1)
+            return found;
+        return scan_node(2 * node + 1, mid, hi, from, size, carry);
+    }
+
+    /**
+     * @brief resolves a scan inside one bitmap word, continuing 'carry'.
+     */
+    int scan_leaf(int w, int from, int size, int& carry){
+        uint64_t word = word_at(w);
+        if(w == SUMMARY_WORDS - 1 && memory_size % 64)
+            word |= ~((1ULL << (memory_size % 64)) - 1);
+        int base = w * 64;
+        // bits below 'from' count as used.
+        if(from > base)
+            word |= (1ULL << (from - base)) - 1;
+
+        int bit = 0;
+        while(bit < 64){
+            int zeros = min(ctz64(word >> bit), 64 - bit);
+            if(zeros > 0){
+                // the carried run only continues if the zeros touch the left edge.
+                int run_len = (bit == 0 ? carry : 0) + zeros;
+                if(run_len >= size)
+                    return base + bit - (bit == 0 ? carry : 0);
+                bit += zeros;
+                if(bit >= 64){
+                    carry = run_len;
+                    return -1;
+                }
+            }
+            bit += min(ctz64(~(word >> bit)), 64 - bit);
+        }
+        carry = 0;
+        return -1;
+    }
+
+    /**
+     * @brief finds the first hole that can accomodate the given size.
+     *
+     * @param size size of the file to fit.
+     * @return int - block index of the first hole.
+     */
+    int first_fit(int size){
+        return scan_zero_run(0, size);
+    }
+
+    /**
+     * @brief finds the smallest hole that can fit the given size.
+     *
+     * @param size size of the file to fit.
+     * @return int - block index of the smallest hole.
+     */
+    int best_fit(int size){
+        if constexpr (fs_stats_enabled)
+            stats.holes_examined++;
+        // smallest hole with length >= size, in O(log H) over the size-ordered index.
+        auto it = holes_by_size.lower_bound({size, INT_MIN});
+        if(it == holes_by_size.end())
+            return -1;
+        return it->second;
+    }
+
+    /**
+     * @brief finds the largest hole that can fit the given size.
+     *
+     * @param size size of the file to fit.
+     * @return int - block index of the largest hole.
+     */
+    int worst_fit(int size){
+        if constexpr (fs_stats_enabled)
+            stats.holes_examined++;
+        // the largest hole overall either fits or nothing does.
+        if(holes_by_size.empty())
+            return -1;
+        auto it = std::prev(holes_by_size.end());
+        if(it->first < size)
+            return -1;
+        return it->second;
+    }
+
+    /**
+     * @brief finds the first hole that can fit the size starting from the point where the last search ended.
+     * 
+     * @param size size of the file to fit.
+     * @return int - block index of the hole.
+     */
+    int next_fit(int size){
+        // scan from where the last search ended, then wrap around once.
+        int i = scan_zero_run(start_index, size);
+        if(i == -1 && start_index > 0)
+            i = scan_zero_run(0, size);
+        if(i == -1)
+            return -1;
+        start_index = (i + size) % memory_size;
+        return i;
+    }
+
+    /**
+     * @brief smallest order whose chunk covers size blocks.
+     */
+    static int order_for(int size){
+        int o = 0;
+        while((1 << o) < size)
+            o++;
+        return o;
+    }
+
+    // blocks actually reserved for a file : the fit strategies allocate
+    // exactly, BUDDY rounds up to the covering chunk.
+    int alloc_span(int size){
+        return strategy == BUDDY ? 1 << order_for(size) : size;
+    }
+
+    /**
+     * @brief rebuilds the per-order freelists from the block bitmap.
+     *
+     * free space decomposes greedily into maximal size-aligned chunks; used
+     * from the constructor (empty bitmap) and after a snapshot load.
+     */
+    void buddy_rebuild(){
+        int top = 0;
+        while((size_t)(1ULL << (top + 1)) <= N)
+            top++;
+        buddy_free.assign(top + 1, {});
+        int pos = 0;
+        while(pos < (int)N){
+            if(memory_map[pos]){
+                pos++;
+                continue;
+            }
+            int run = 0;
+            while(pos + run < (int)N && !memory_map[pos + run])
+                run++;
+            // carve the run into chunks no larger than their alignment allows.
+            int p = pos, left = run;
+            while(left > 0){
+                int o = top;
+                while((1 << o) > left || (p & ((1 << o) - 1)))
+                    o--;
+                buddy_free[o].insert(p);
+                p += 1 << o;
+                left -= 1 << o;
+            }
+            pos += run;
+        }
+    }
+
+    /**
+     * @brief takes a chunk of the given order, splitting a larger one if needed.
+     *
+     * @param order chunk order to allocate.
+     * @return int - start block of the chunk, -1 when nothing big enough is free.
+     */
+    int buddy_take(int order){
+        int o = order;
+        while(o < (int)buddy_free.size() && buddy_free[o].empty())
+            o++;
+        if(o >= (int)buddy_free.size())
+            return -1;
+        int start = *buddy_free[o].begin();
+        buddy_free[o].erase(buddy_free[o].begin());
+        // split down to the requested order, keeping the upper halves free.
+        while(o > order){
+            o--;
+            if constexpr (fs_stats_enabled)
+                stats.scan_steps++;
+            buddy_free[o].insert(start + (1 << o));
+        }
+        return start;
+    }
+
+    /**
+     * @brief frees a chunk, coalescing with its free buddy as far as possible.
+     */
+    void buddy_release(int start, int order){
+        while(order + 1 < (int)buddy_free.size()){
+            int buddy = start ^ (1 << order);
+            auto it = buddy_free[order].find(buddy);
+            if(it == buddy_free[order].end())
+                break;
+            buddy_free[order].erase(it);
+            start = min(start, buddy);
+            order++;
+        }
+        buddy_free[order].insert(start);
+    }
+
+    /**
+     * @brief Get the starting block index of the alloted contiguous block based on the strategy.
+     * 
+     * @param size size to fit.
+     * @return int starting index of the block.
+     */
+    int get_index(int size){
+        // a pinned strategy resolves to a direct, inlinable call; only
+        // DYNAMIC instantiations keep the runtime chain.
+        if constexpr (S == ::FIRST_FIT)
+            return first_fit(size);
+        else if constexpr (S == ::BEST_FIT)
+            return best_fit(size);
+        else if constexpr (S == ::WORST_FIT)
+            return worst_fit(size);
+        else if constexpr (S == ::BUDDY)
+            return buddy_take(order_for(size));
+        else if constexpr (S == ::NEXT_FIT)
+            return next_fit(size);
+        else if(strategy == FIRST_FIT)
+            return first_fit(size);
+        else if(strategy == BEST_FIT)
+            return best_fit(size);
+        else if(strategy == WORST_FIT)
+            return worst_fit(size);
+        else if(strategy == BUDDY)
+            return buddy_take(order_for(size));
+        else
+            return next_fit(size);
+    }
+
+};
+
+/**
+ * @brief block-chain layout policy for LinkedFileSystem.
+ *
+ * CHAIN keeps a next pointer inside every block node (classic linked allocation),
+ * FAT keeps all next links in one flat table indexed by block id, so chain
+ * traversal is array reads instead of pointer chasing.
+ */
+enum LinkedLayout { CHAIN, FAT };
+
+/**
+ * @brief A file system which allocates linked list of blocks to each file.
+ *
+ * @tparam N size of the memory.
+ * @tparam L chain layout, CHAIN (pointer per block) or FAT (flat next table).
+ */
+template<size_t N = 1024, LinkedLayout L = CHAIN>
+class LinkedFileSystem{
+
+    private:
+
+    struct block{
+        int id;
+        block* next;
+        block() : id(0), next(nullptr) {}
+        block(int id, block* next = nullptr){
+            this->id = id;
+            this->next = next;
+        }
+    };
+
+    class File {
+        int filesize;
+        int start_block;
+        int last_block;  // tail of the chain, so delete can splice it back in O(1).
+        string name;      // so handle-based deletes can erase the map entry.
+        int handle = -1;  // slot in the handle table, -1 while unopened.
+        int cursor_bno = -1;    // logical block where the last read ended, -1 when invalid.
+        int cursor_block = -1;  // physical block at cursor_bno.
+        File(int filesize, int start, int last) : filesize(filesize), start_block(start), last_block(last) {}
+        friend class LinkedFileSystem;
+    };
+
+    // CHAIN : all block nodes live in one contiguous arena and free blocks are
+    // threaded through their own next pointers. FAT : the chain lives in a flat
+    // next table indexed by block id and no nodes are needed at all.
+    vector<block> arena;
+    vector<int32_t> next_table;
+    int free_head;
+    int free_count;
+    int lazy_next;  // blocks at index >= lazy_next have never been handed out yet.
+    DirTree<File> file_map;
+    vector<File*> handles;  // open-handle table; slots of deleted files are nulled.
+    int used_memory;
+    Verbosity verbosity = TRACE;
+    BufferCache* cache = nullptr;
+    FsStats stats;
+    CostModel cost_model;
+    AtomicIoResult last_io;
+    int readahead = 8;  // blocks prefetched into the cache on sequential reads.
+
+    size_t metadata_budget = 0;  // host bytes allowed for metadata, 0 = unbounded.
+    size_t mem_high_water = 0;   // largest footprint total seen so far.
+
+    // slab of File records : stored by value in a deque so addresses stay
+    // stable for a record's whole life, with freed slots recycled through a
+    // freelist. no per-file new/delete, and teardown is just the deque dying.
+    deque<File> slab;
+    vector<File*> slab_free;
+
+    /**
+     * @brief takes a File record off the slab, reusing a freed slot if any.
+     */
+    File* alloc_file(int size, int start, int last){
+        if(!slab_free.empty()){
+            File* fp = slab_free.back();
+            slab_free.pop_back();
+            *fp = File(size, start, last);
+            return fp;
+        }
+        slab.push_back(File(size, start, last));
+        return &slab.back();
+    }
+
+    /**
+     * @brief returns a dead File record's slot to the slab freelist.
+     */
+    void release_file(File* fp){
+        slab_free.push_back(fp);
+    }
+
+    /**
+     * @brief resolves a handle back to its file, nullptr for stale or bad handles.
+     */
+    File* handle_file(int fd){
+        if(fd < 0 || fd >= (int)handles.size())
+            return nullptr;
+        return handles[fd];
+    }
+
+    /**
+     * @brief returns the block chained after the given one, -1 at end of chain.
+     */
+    int next_of(int id){
+        if constexpr (L == FAT)
+            return next_table[id];
+        else
+            return arena[id].next ? arena[id].next->id : -1;
+    }
+
+    /**
+     * @brief links 'nxt' (-1 to terminate) after the given block.
+     */
+    void set_next(int id, int nxt){
+        if constexpr (L == FAT)
+            next_table[id] = nxt;
+        else
+            arena[id].next = (nxt == -1) ? nullptr : &arena[nxt];
+    }
+
+    /**
+     * @brief takes one block off the freelist, initializing it lazily on first use.
+     *
+     * @return int - id of a free block with its next link cleared.
+     */
+    int pop_free(){
+        int b;
+        if(free_head != -1){
+            b = free_head;
+            free_head = next_of(b);
+        }
+        else{
+            b = lazy_next;
+            if constexpr (L == CHAIN)
+                arena[b].id = b;
+            lazy_next++;
+        }
+        set_next(b, -1);
+        free_count--;
+        return b;
+    }
+
+    /**
+     * @brief takes a run of 'size' blocks off the freelist as one splice.
+     *
+     * Freed chains keep their links, so the run is cut off the front of the
+     * freelist with a single write instead of relinking every node; only
+     * blocks drawn from the lazy region still need linking.
+     *
+     * @param size number of blocks to take. caller must have checked free_count.
+     * @param last set to the id of the last block of the run.
+     * @return int - id of the first block of the run.
+     */
+    int take_run(int size, int& last){
+        int start, got = 0;
+        if constexpr (fs_stats_enabled){
+            stats.scan_steps += size;
+            stats.last_scan_steps = size;
+        }
+
+        if(free_head != -1){
+            start = free_head;
+            int cur = free_head;
+            got = 1;
+            while(got < size && next_of(cur) != -1){
+                cur = next_of(cur);
+                got++;
+            }
+            free_head = next_of(cur);
+            set_next(cur, -1);
+            last = cur;
+            free_count -= got;
+        }
+        else{
+            start = last = pop_free();
+            got = 1;
+        }
+
+        // top up from the never-used region if the freelist chain ran short.
+        while(got < size){
+            int b = pop_free();
+            set_next(last, b);
+            last = b;
+            got++;
+        }
+
+        return start;
+    }
+
+    public:
+
+    /**
+     * @brief Construct a new Linked File System object
+     *
+     */
+    LinkedFileSystem() : free_head(-1), free_count(N), lazy_next(0), used_memory(0){
+        // one allocation for the chain storage; the free chain itself is built lazily.
+        if constexpr (L == FAT)
+            next_table.assign(N, -1);
+        else
+            arena.resize(N);
+    }
+
+    // file records live by value in a slab owned by the instance, so the
+    // filesystem moves wholesale but must not be copied (the maps hold
+    // pointers into the slab).
+    LinkedFileSystem(LinkedFileSystem&&) = default;
+    LinkedFileSystem(const LinkedFileSystem&) = delete;
+
+    /**
+     * @brief sets how much this filesystem logs.
+     *
+     * @param v QUIET/SUMMARY/TRACE.
+     */
+    void set_verbosity(Verbosity v){
+        verbosity = v;
+    }
+
+    /**
+     * @brief puts a buffer cache in front of this filesystem's block accesses.
+     *
+     * @param c the cache, may be shared with other filesystems. nullptr detaches.
+     */
+    void attach_cache(BufferCache* c){
+        cache = c;
+    }
+
+    /**
+     * @brief sets how many blocks a sequential read prefetches into the cache.
+     *
+     * @param w window size in blocks, 0 disables readahead.
+     */
+    void set_readahead(int w){
+        readahead = w;
+    }
+
+    /**
+     * @brief instrumentation counters; the free-list length here is the number
+     * of free blocks, since the chained freelist has no runs.
+     *
+     * all counters read zero when stats are compiled out with -DFS_NO_STATS.
+     */
+    FsStats get_stats(){
+        stats.free_runs = free_count;
+        return stats;
+    }
+
+    /**
+     * @brief replaces the cost model used to charge block touches.
+     */
+    void set_cost_model(CostModel m){
+        cost_model = m;
+    }
+
+    /**
+     * @brief blocks moved and modeled cost of the most recent read/write.
+     */
+    IoResult get_last_io(){
+        return last_io;
+    }
+
+    /**
+     * @brief returns zero-copy views over the file's bytes in [offset, offset+len).
+     *
+     * physically adjacent chain links collapse into a single view, so a well
+     * laid out file comes back as one run even though it is block-chained.
+     *
+     * @param filename name of the file.
+     * @param len number of bytes, -1 for everything from the offset on.
+     * @param offset starting byte within the file.
+     * @return views into the backing store, empty on error.
+     */
+    vector<BlockView> map_file(string filename, int len = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "LinkedFileSystem::map_file() : File " << filename << " not found\n";
+            return {};
+        }
+        return map_views(fp, len, offset);
+    }
+
+    /**
+     * @brief copies the file's bytes in [offset, offset+len) into buf.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int read(string filename, char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return gather_bytes(views, buf);
+    }
+
+    /**
+     * @brief copies len bytes of buf into the file at the given byte offset.
+     *
+     * the write must fit inside the file's allocated blocks; the data plane
+     * never grows a file.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int write(string filename, const char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return scatter_bytes(views, buf);
+    }
+
+    private:
+
+    vector<char> store;  // data plane backing memory, sized lazily on first use.
+
+    /**
+     * @brief base of the backing store, allocating it on first touch.
+     */
+    char* store_base(){
+        if(store.empty())
+            store.resize(N * FS_BLOCK_SIZE);
+        return store.data();
+    }
+
+    /**
+     * @brief walks the chain and collects physical runs, coalescing adjacent ids.
+     */
+    vector<pair<int, int>> physical_runs(File* fp){
+        vector<pair<int, int>> runs;
+        for(int b = fp->start_block; b != -1; b = next_of(b)){
+            if(!runs.empty() && runs.back().first + runs.back().second == b)
+                runs.back().second++;
+            else
+                runs.push_back({b, 1});
+        }
+        return runs;
+    }
+
+    /**
+     * @brief clips a byte range against the file and builds its view list.
+     */
+    vector<BlockView> map_views(File* fp, int len, int offset){
+        int limit = fp->filesize * (int)FS_BLOCK_SIZE;
+        if(len == -1)
+            len = limit - offset;
+        if(offset < 0 || len < 0 || offset + len > limit){
+            cerr << "LinkedFileSystem::map_file() : byte range past end of file\n";
+            return {};
+        }
+        if(len == 0)
+            return {};
+        return runs_to_views(store_base(), physical_runs(fp), offset, len);
+    }
+
+    public:
+
+    /**
+     * @brief writes the filesystem metadata to a flat binary snapshot.
+     *
+     * The chain links are stored as one int32 array indexed by block id
+     * (only the lazily-initialized region is written), regardless of layout.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool save_snapshot(const string& path){
+        ofstream out(path, ios::binary);
+        if(!out){
+            cerr << "LinkedFileSystem::save_snapshot() : cannot open " << path << "\n";
+            return false;
+        }
+        out.write(SNAP_MAGIC, sizeof(SNAP_MAGIC));
+        out.put('L');
+        uint64_t n = N;
+        snap_put(out, n);
+        snap_put(out, used_memory);
+        snap_put(out, free_head);
+        snap_put(out, free_count);
+        snap_put(out, lazy_next);
+        for(int i = 0; i < lazy_next; i++){
+            int32_t nxt = next_of(i);
+            snap_put(out, nxt);
+        }
+        uint32_t nfiles = file_map.size();
+        snap_put(out, nfiles);
+        file_map.for_each([&](File* fp){
+            snap_put_str(out, fp->name);
+            snap_put(out, fp->filesize);
+            snap_put(out, fp->start_block);
+            snap_put(out, fp->last_block);
+        });
+        return out.good();
+    }
+
+    /**
+     * @brief restores the filesystem metadata from a snapshot, replacing all state.
+     *
+     * Snapshots are interchangeable between the CHAIN and FAT layouts; open
+     * handles do not survive a load.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool load_snapshot(const string& path){
+        size_t len;
+        const char* p;
+        const char* base = snap_map(path.c_str(), 'L', len, p);
+        if(!base){
+            cerr << "LinkedFileSystem::load_snapshot() : cannot load " << path << "\n";
+            return false;
+        }
+        const char* e = base + len;
+
+        file_map.clear();
+        handles.clear();
+        slab.clear();
+        slab_free.clear();
+
+        uint64_t n = 0;
+        bool ok = snap_get(p, e, n) && n == N
+               && snap_get(p, e, used_memory) && snap_get(p, e, free_head)
+               && snap_get(p, e, free_count) && snap_get(p, e, lazy_next)
+               // lazy_next sizes the arena writes below; the rest must be
+               // sane block counts or ids before anything indexes with them.
+               && snap_range_ok(0, lazy_next, N) && snap_range_ok(0, used_memory, N)
+               && snap_range_ok(0, free_count, N)
+               && free_head >= -1 && free_head < lazy_next;
+
+        for(int i = 0; ok && i < lazy_next; i++){
+            int32_t nxt;
+            ok = snap_get(p, e, nxt) && nxt >= -1 && nxt < lazy_next;
+            if(ok){
+                if constexpr (L == CHAIN)
+                    arena[i].id = i;
+                set_next(i, nxt);
+            }
+        }
+
+        uint32_t nfiles = 0;
+        ok = ok && snap_get(p, e, nfiles);
+        for(uint32_t i = 0; ok && i < nfiles; i++){
+            string fname;
+            int fsz = 0, sb = 0, lb = 0;
+            ok = snap_get_str(p, e, fname) && snap_get(p, e, fsz)
+              && snap_get(p, e, sb) && snap_get(p, e, lb)
+              && snap_range_ok(0, fsz, N)
+              && sb >= -1 && sb < lazy_next && lb >= -1 && lb < lazy_next
+              && (sb == -1) == (fsz == 0);
+            if(ok){
+                File* fp = alloc_file(fsz, sb, lb);
+                fp->name = fname;
+                file_map.insert(fname, fp);
+            }
+        }
+
+        munmap((void*)base, len);
+        if(!ok)
+            cerr << "LinkedFileSystem::load_snapshot() : snapshot " << path << " is corrupt\n";
+        return ok;
+    }
+
+    /**
+     * @brief Creates a file of given size. Allocates non contiguous linked blocks of memory.
+     * 
+     * @param filename name of the file.
+     * @param filesize size of the file.
+     */
+    void create(string filename, int size){
+        StatsTimer _t(stats.create_ns);
+        if constexpr (fs_stats_enabled)
+            stats.creates++;
+        size_t buckets = file_map.bucket_count();
+        if(file_map.find(filename)){
+            cerr << "LinkedFileSystem::create() : Filename already taken\n";
+            return;
+        }
+
+        // bounded-metadata mode : refuse growth once host metadata passes the cap.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "LinkedFileSystem::create() : metadata budget exceeded, cannot create " << filename << "\n";
+            return;
+        }
+
+        //if there are less number of blocks in free list than required, return.
+        if(free_count < size){
+            cerr << "LinkedFileSystem::write() : cannot allocate " << size << " blocks for " << filename << endl;
+            return;
+        }
+
+        // take the whole run off the freelist in one splice. a zero-size
+        // file gets an empty chain; taking a block for it would leak, since
+        // drop_file only returns filesize blocks.
+        int start = -1, last = -1;
+        if(size > 0)
+            start = take_run(size, last);
+
+        File* fp = alloc_file(size, start, last);
+        fp->name = filename;
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::write() : File " << filename << " created with starting block " << start << endl;
+
+        used_memory += size;
+
+        file_map.insert(filename, fp);
+        if constexpr (fs_stats_enabled)
+            if(file_map.bucket_count() != buckets)
+                stats.rehashes++;
+    }
+
+    /**
+     * @brief creates a batch of files in one call.
+     *
+     * every create here already splices its whole chain off the freelist
+     * head in one step, so there is no scan to amortize; the batch applies
+     * the creates in order and lets the concurrent wrapper lock once for
+     * the burst.
+     *
+     * @param files name/size pairs to create.
+     * @return int - number of files actually created.
+     */
+    int create_batch(const vector<pair<string, int>>& files){
+        size_t before = file_map.size();
+        for(auto& f : files)
+            create(f.first, f.second);
+        return file_map.size() - before;
+    }
+
+    /**
+     * @brief deletes a batch of files in one call; each splice is O(1).
+     *
+     * @param filenames files to delete.
+     * @return int - number of files deleted.
+     */
+    int delete_batch(const vector<string>& filenames){
+        size_t before = file_map.size();
+        for(auto& name : filenames)
+            delete_file(name);
+        return before - file_map.size();
+    }
+
+    /**
+     * @brief resolves a filename to a small integer handle for the hot-path overloads.
+     *
+     * The handle stays valid until the file is deleted; opening the same file
+     * again returns the same handle.
+     *
+     * @param filename name of the file.
+     * @return int - file handle, -1 if the file does not exist.
+     */
+    int open_file(const string& filename){
+        File* fp = file_map.find(filename);
+        if(!fp)
+            return -1;
+        if(fp->handle == -1){
+            fp->handle = handles.size();
+            handles.push_back(fp);
+        }
+        return fp->handle;
+    }
+
+    /**
+     * @brief reads 'size' blocks of the file from given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to read.
+     * @param offset block number to start reading.
+     * @return int - number of block accesses taken to read the file.
+     */
+    int read(string filename, int size, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "LinkedFileSystem::read() : File " << filename << " not found\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    /**
+     * @brief reads by file handle, skipping the name lookup.
+     */
+    int read(int fd, int size, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "LinkedFileSystem::read() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    private:
+
+    int read_file(File* fp, int size, int offset){
+        int block_access = 1;
+
+        // sequential streams resume from the remembered cursor instead of
+        // re-walking the chain from the head, so successive reads through a
+        // large file cost O(n) in total rather than O(n^2).
+        int start = fp->start_block;
+        int bno = 0;
+        bool sequential = fp->cursor_bno >= 0 && offset >= fp->cursor_bno;
+        if(sequential){
+            start = fp->cursor_block;
+            bno = fp->cursor_bno;
+        }
+
+        int read = 0;
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
+
+        //iterate through the list and read the blocks greater than offset.
+        while(start != -1 && read < size){
+            if(bno >= offset){
+                read++;
+                if(fs_trace(verbosity))
+                    cout << "LinkedFileSystem::read() : Reading block " << start << endl;
+            }
+            bno++;
+            bool hit = cache && cache->access(start);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, start, hit);
+            start = next_of(start);
+        }
+        last_io = io;
+
+        // remember where this read ended; the next read picking up here skips
+        // the whole re-traversal.
+        if(start != -1){
+            fp->cursor_bno = bno;
+            fp->cursor_block = start;
+        }
+        else{
+            fp->cursor_bno = -1;
+        }
+
+        // on a detected sequential stream, warm the cache with the next window
+        // so the following call's data blocks are already resident.
+        if(sequential && cache){
+            int ahead = start;
+            for(int i = 0; i < readahead && ahead != -1; i++){
+                cache->access(ahead);
+                ahead = next_of(ahead);
+            }
+        }
+
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::read() : Total blocks read : " << read << endl;
+
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief writes 'size' blocks starting from the given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to write.
+     * @param offset starting block to write from.
+     * @return int - number of block accesses taken to write the file
+     */
+    int write(string filename, int size, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "LinkedFileSystem::write() : File " << filename << " not found\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    /**
+     * @brief writes by file handle, skipping the name lookup.
+     */
+    int write(int fd, int size, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "LinkedFileSystem::write() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    private:
+
+    int write_file(File* fp, int size, int offset){
+        int block_access = 1;
+
+        // if the required number of overflow blocks is greater than the size of the free list, return.
+        if(offset + size > fp->filesize && offset + size - fp->filesize  > free_count){
+            cerr << "LinkedFileSystem::write() : cannot allocate memory for write\n";
+            return block_access;
+        }
+
+        int curr = fp->start_block, prev = -1;
+
+        int bno = 0, written = 0;
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev_touch = INT_MIN;
+
+        //iterate through the list overwrite if block number greater than offset. allocate overflow blocks as when required.
+        while(written != size){
+            if(curr == -1){
+                curr = pop_free();
+                if(prev == -1)
+                    fp->start_block = curr;  // growing from an empty chain.
+                else
+                    set_next(prev, curr);
+                fp->last_block = curr;
+                if(fs_trace(verbosity))
+                    cout << "LinkedFileSystem::write() : Allocating new block " << curr << endl;
+                fp->filesize++;
+                used_memory++;
+            }
+
+            if(bno >= offset){
+                if(fs_trace(verbosity))
+                    cout << "LinkedFileSystem::write() : writing block " << curr << endl;
+                written++;
+            }
+
+            bno++;
+            bool hit = cache && cache->access(curr);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev_touch, curr, hit);
+            prev = curr;
+            curr = next_of(curr);
+        }
+
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::write() : Total blocks written : " << written << endl;
+
+        last_io = io;
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief removes the given file from the filesystem.
+     *
+     * @param filename name of the file.
+     */
+    void delete_file(string filename){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "LinkedFileSystem::delete() : File not found.\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes by file handle, skipping the name lookup.
+     */
+    void delete_file(int fd){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "LinkedFileSystem::delete() : bad file handle " << fd << "\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes every file under the given directory in one pass.
+     *
+     * the subtree is unlinked from the namespace once and each file's
+     * resources are then reaped, so the cost is O(files under dirname)
+     * rather than a scan of the whole namespace.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return int - number of files deleted.
+     */
+    int delete_tree(string dirname){
+        int removed = file_map.erase_under(dirname, [&](File* fp){ drop_file(fp); });
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::delete_tree() : " << removed << " files deleted under " << dirname << endl;
+        return removed;
+    }
+
+    /**
+     * @brief full names of every file under the given directory.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return vector<string> - the files' full paths.
+     */
+    vector<string> list_dir(string dirname){
+        vector<string> out;
+        file_map.for_each_under(dirname, [&](File* fp){ out.push_back(fp->name); });
+        return out;
+    }
+
+    private:
+
+    // namespace removal and resource teardown are separate so the
+    // subtree delete can unlink a whole directory once and reap per file.
+    void delete_fp(File* fp){
+        file_map.erase(fp->name);
+        drop_file(fp);
+    }
+
+    void drop_file(File* fp){
+        StatsTimer _t(stats.delete_ns);
+        if constexpr (fs_stats_enabled)
+            stats.deletes++;
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::delete() : deallocating file blocks\n";
+
+        // splice the whole chain onto the front of the free list in O(1);
+        // a zero-size file owns no blocks and has nothing to splice.
+        if(fp->start_block != -1){
+            set_next(fp->last_block, free_head);
+            free_head = fp->start_block;
+            free_count += fp->filesize;
+        }
+
+        if(fp->handle != -1)
+            handles[fp->handle] = nullptr;
+        used_memory -= fp->filesize;
+        if(fs_summary(verbosity))
+            cout << "LinkedFileSystem::delete() : " << fp->name << " deleted\n";
+        release_file(fp);
+    }
+
+    public:
+
+    /**
+     * @brief Get the storage efficiency of the file system.
+     * 
+     * @return float - returns the ratio of used memory to the total memory size.
+     */
+    float get_storage_efficiency(){
+        return (float)used_memory/N;
+    }
+
+    /**
+     * @brief estimated host-heap bytes behind this instance, by structure.
+     *
+     * the chain arena (CHAIN) or next table (FAT) is the fixed cost here :
+     * roughly 16 or 4 bytes per simulated block before any file exists.
+     */
+    MemoryFootprint get_memory_footprint(){
+        MemoryFootprint f;
+        f.block_store = store.capacity() + vec_heap_bytes(arena) + vec_heap_bytes(next_table);
+        f.file_records = deque_heap_bytes(slab) + vec_heap_bytes(slab_free);
+        for(const File& rec : slab)
+            f.file_records += string_heap_bytes(rec.name);
+        // the free chain threads through the arena / next table, so the
+        // freelist itself costs nothing extra.
+        f.name_map = file_map.footprint() + vec_heap_bytes(handles);
+        if(f.total() > mem_high_water)
+            mem_high_water = f.total();
+        return f;
+    }
+
+    /**
+     * @brief bounded-metadata mode : creates fail once the footprint
+     * passes the budget. 0 (the default) lifts the cap.
+     */
+    void set_metadata_budget(size_t bytes){
+        metadata_budget = bytes;
+    }
+
+    /**
+     * @brief largest footprint total observed so far; refreshed here and
+     * by every budget check and get_memory_footprint() call.
+     */
+    size_t get_metadata_high_water(){
+        get_memory_footprint();
+        return mem_high_water;
+    }
+};
+
+/**
+ * @brief A file system which allocates non contiguous blocks to each file. the block numbers are stored in the metafile.
+ * 
+ * @tparam N size of the memory.
+ */
+template<size_t N = 1024>
+class IndexedFileSystem{
+    private:
+    // one extent-compressed index : (start, length) runs instead of one entry
+    // per block, with cumulative logical offsets for binary-search lookup.
+    // clones share a table copy-on-write; refs counts the File records
+    // pointing at it and the blocks are freed when the last one goes.
+    struct ExtentTable{
+        vector<pair<int, int>> extents;
+        vector<int> ext_off;  // ext_off[i] = logical block number where extents[i] begins.
+        int refs = 0;
+    };
+
+    class File {
+        int filesize;
+        ExtentTable* tab = nullptr;
+        string name;      // so handle-based deletes can erase the map entry.
+        int handle = -1;  // slot in the handle table, -1 while unopened.
+        File(int filesize) : filesize(filesize) {}
+        friend class IndexedFileSystem;
+    };
+
+    DirTree<File> file_map;
+    vector<File*> handles;  // open-handle table; slots of deleted files are nulled.
+
+    /**
+     * @brief resolves a handle back to its file, nullptr for stale or bad handles.
+     */
+    File* handle_file(int fd){
+        if(fd < 0 || fd >= (int)handles.size())
+            return nullptr;
+        return handles[fd];
+    }
+    FsStats stats;
+    CostModel cost_model;
+    AtomicIoResult last_io;
+
+    size_t metadata_budget = 0;  // host bytes allowed for metadata, 0 = unbounded.
+    size_t mem_high_water = 0;   // largest footprint total seen so far.
+
+    // slab of File records : stored by value in a deque so addresses stay
+    // stable for a record's whole life, with freed slots recycled through a
+    // freelist. no per-file new/delete, and teardown is just the deque dying.
+    deque<File> slab;
+    vector<File*> slab_free;
+
+    /**
+     * @brief takes a File record off the slab, reusing a freed slot if any.
+     */
+    File* alloc_file(int size){
+        if(!slab_free.empty()){
+            File* fp = slab_free.back();
+            slab_free.pop_back();
+            *fp = File(size);
+            return fp;
+        }
+        slab.push_back(File(size));
+        return &slab.back();
+    }
+
+    /**
+     * @brief returns a dead File record's slot to the slab freelist.
+     */
+    void release_file(File* fp){
+        slab_free.push_back(fp);
+    }
+
+    // slab of extent tables, recycled the same way as File records.
+    deque<ExtentTable> tab_slab;
+    vector<ExtentTable*> tab_free;
+
+    ExtentTable* alloc_table(){
+        if(!tab_free.empty()){
+            ExtentTable* t = tab_free.back();
+            tab_free.pop_back();
+            t->refs = 1;
+            return t;
+        }
+        tab_slab.push_back(ExtentTable());
+        tab_slab.back().refs = 1;
+        return &tab_slab.back();
+    }
+
+    void release_table(ExtentTable* t){
+        t->extents.clear();
+        t->ext_off.clear();
+        tab_free.push_back(t);
+    }
+
+    map<int, int> free_extents;  // start block -> run length, ordered by start.
+    int free_count;
+    int used_memory;
+    Verbosity verbosity = TRACE;
+    BufferCache* cache = nullptr;
+
+    /**
+     * @brief returns a run of blocks to the free store, coalescing with neighbours.
+     *
+     * @param start starting block of the run.
+     * @param len number of blocks in the run.
+     */
+    void free_run(int start, int len){
+        free_count += len;
+        auto next = free_extents.lower_bound(start);
+        if(next != free_extents.begin()){
+            auto prev = std::prev(next);
+            if(prev->first + prev->second == start){
+                start = prev->first;
+                len += prev->second;
+                free_extents.erase(prev);
+            }
+        }
+        if(next != free_extents.end() && start + len == next->first){
+            len += next->second;
+            free_extents.erase(next);
+        }
+        free_extents[start] = len;
+    }
+
+    /**
+     * @brief carves up to 'want' blocks off the lowest free run.
+     *
+     * @param want maximum number of blocks wanted.
+     * @param len set to the number of blocks actually taken.
+     * @return int - starting block of the run taken.
+     */
+    int alloc_run(int want, int& len){
+        if constexpr (fs_stats_enabled){
+            stats.holes_examined++;
+            stats.scan_steps++;
+        }
+        auto it = free_extents.begin();
+        int start = it->first;
+        len = min(want, it->second);
+        if(len == it->second)
+            free_extents.erase(it);
+        else{
+            int rest_start = start + len, rest_len = it->second - len;
+            free_extents.erase(it);
+            free_extents[rest_start] = rest_len;
+        }
+        free_count -= len;
+        return start;
+    }
+
+    /**
+     * @brief appends a run to a file's extent list, merging with the last extent
+     * when the run is contiguous with it.
+     */
+    void append_extent(File* fp, int start, int len){
+        ExtentTable* t = fp->tab;
+        if(!t->extents.empty() && t->extents.back().first + t->extents.back().second == start){
+            t->extents.back().second += len;
+            return;
+        }
+        t->ext_off.push_back(t->extents.empty() ? 0 : t->ext_off.back() + t->extents.back().second);
+        t->extents.push_back({start, len});
+    }
+
+    /**
+     * @brief maps a logical block number of the file to its physical block.
+     *
+     * @param fp the file.
+     * @param bno logical block number.
+     * @return int - physical block id.
+     */
+    int block_at(File* fp, int bno){
+        // last extent whose logical offset is <= bno.
+        ExtentTable* t = fp->tab;
+        auto it = std::prev(upper_bound(t->ext_off.begin(), t->ext_off.end(), bno));
+        int e = it - t->ext_off.begin();
+        return t->extents[e].first + (bno - *it);
+    }
+
+    public:
+    /**
+     * @brief Construct a new Indexed File System object
+     *
+     */
+    IndexedFileSystem() : free_count(N), used_memory(0){
+        free_extents[0] = N;
+    }
+
+    // file records live by value in a slab owned by the instance, so the
+    // filesystem moves wholesale but must not be copied (the maps hold
+    // pointers into the slab).
+    IndexedFileSystem(IndexedFileSystem&&) = default;
+    IndexedFileSystem(const IndexedFileSystem&) = delete;
+
+    /**
+     * @brief sets how much this filesystem logs.
+     *
+     * @param v QUIET/SUMMARY/TRACE.
+     */
+    void set_verbosity(Verbosity v){
+        verbosity = v;
+    }
+
+    /**
+     * @brief puts a buffer cache in front of this filesystem's block accesses.
+     *
+     * @param c the cache, may be shared with other filesystems. nullptr detaches.
+     */
+    void attach_cache(BufferCache* c){
+        cache = c;
+    }
+
+    /**
+     * @brief instrumentation counters, with the live free-extent count filled in.
+     *
+     * all counters read zero when stats are compiled out with -DFS_NO_STATS.
+     */
+    FsStats get_stats(){
+        stats.free_runs = free_extents.size();
+        return stats;
+    }
+
+    /**
+     * @brief replaces the cost model used to charge block touches.
+     */
+    void set_cost_model(CostModel m){
+        cost_model = m;
+    }
+
+    /**
+     * @brief blocks moved and modeled cost of the most recent read/write.
+     */
+    IoResult get_last_io(){
+        return last_io;
+    }
+
+    /**
+     * @brief returns zero-copy views over the file's bytes in [offset, offset+len).
+     *
+     * one view per extent touched; the extent list already stores the physical
+     * runs, so no per-block walk is needed.
+     *
+     * @param filename name of the file.
+     * @param len number of bytes, -1 for everything from the offset on.
+     * @param offset starting byte within the file.
+     * @return views into the backing store, empty on error.
+     */
+    vector<BlockView> map_file(string filename, int len = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "IndexedFileSystem::map_file() : File " << filename << " not found\n";
+            return {};
+        }
+        return map_views(fp, len, offset);
+    }
+
+    /**
+     * @brief copies the file's bytes in [offset, offset+len) into buf.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int read(string filename, char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return gather_bytes(views, buf);
+    }
+
+    /**
+     * @brief copies len bytes of buf into the file at the given byte offset.
+     *
+     * the write must fit inside the file's allocated blocks; the data plane
+     * never grows a file.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int write(string filename, const char* buf, int len, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "IndexedFileSystem::map_file() : File " << filename << " not found\n";
+            return -1;
+        }
+        // byte writes go around write_file, so the copy-on-write break
+        // happens here before the views are built.
+        if(materialize(fp) < 0)
+            return -1;
+        auto views = map_views(fp, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return scatter_bytes(views, buf);
+    }
+
+    private:
+
+    vector<char> store;  // data plane backing memory, sized lazily on first use.
+
+    /**
+     * @brief base of the backing store, allocating it on first touch.
+     */
+    char* store_base(){
+        if(store.empty())
+            store.resize(N * FS_BLOCK_SIZE);
+        return store.data();
+    }
+
+    /**
+     * @brief clips a byte range against the file and builds its view list.
+     */
+    vector<BlockView> map_views(File* fp, int len, int offset){
+        int limit = fp->filesize * (int)FS_BLOCK_SIZE;
+        if(len == -1)
+            len = limit - offset;
+        if(offset < 0 || len < 0 || offset + len > limit){
+            cerr << "IndexedFileSystem::map_file() : byte range past end of file\n";
+            return {};
+        }
+        if(len == 0)
+            return {};
+        return runs_to_views(store_base(), fp->tab->extents, offset, len);
+    }
+
+    public:
+
+    /**
+     * @brief writes the filesystem metadata to a flat binary snapshot.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool save_snapshot(const string& path){
+        ofstream out(path, ios::binary);
+        if(!out){
+            cerr << "IndexedFileSystem::save_snapshot() : cannot open " << path << "\n";
+            return false;
+        }
+        out.write(SNAP_MAGIC, sizeof(SNAP_MAGIC));
+        out.put('I');
+        uint64_t n = N;
+        snap_put(out, n);
+        snap_put(out, used_memory);
+        snap_put(out, free_count);
+        uint32_t nfree = free_extents.size();
+        snap_put(out, nfree);
+        for(auto& fe : free_extents){
+            snap_put(out, fe.first);
+            snap_put(out, fe.second);
+        }
+        // shared tables are written once and referenced by id, so clones
+        // stay clones across a save/load cycle.
+        vector<ExtentTable*> tabs;
+        unordered_map<ExtentTable*, uint32_t> tab_id;
+        file_map.for_each([&](File* fp){
+            if(tab_id.insert({fp->tab, (uint32_t)tabs.size()}).second)
+                tabs.push_back(fp->tab);
+        });
+        uint32_t ntabs = tabs.size();
+        snap_put(out, ntabs);
+        for(ExtentTable* t : tabs){
+            uint32_t next = t->extents.size();
+            snap_put(out, next);
+            for(auto& ex : t->extents){
+                snap_put(out, ex.first);
+                snap_put(out, ex.second);
+            }
+        }
+        uint32_t nfiles = file_map.size();
+        snap_put(out, nfiles);
+        file_map.for_each([&](File* fp){
+            snap_put_str(out, fp->name);
+            snap_put(out, fp->filesize);
+            snap_put(out, tab_id[fp->tab]);
+        });
+        return out.good();
+    }
+
+    /**
+     * @brief restores the filesystem metadata from a snapshot, replacing all state.
+     *
+     * Open handles do not survive a load.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool load_snapshot(const string& path){
+        size_t len;
+        const char* p;
+        const char* base = snap_map(path.c_str(), 'I', len, p);
+        if(!base){
+            cerr << "IndexedFileSystem::load_snapshot() : cannot load " << path << "\n";
+            return false;
+        }
+        const char* e = base + len;
+
+        file_map.clear();
+        handles.clear();
+        slab.clear();
+        slab_free.clear();
+        tab_slab.clear();
+        tab_free.clear();
+        free_extents.clear();
+
+        uint64_t n = 0;
+        bool ok = snap_get(p, e, n) && n == N
+               && snap_get(p, e, used_memory) && snap_get(p, e, free_count)
+               && snap_range_ok(0, used_memory, N) && snap_range_ok(0, free_count, N);
+
+        uint32_t nfree = 0;
+        ok = ok && snap_get(p, e, nfree);
+        for(uint32_t i = 0; ok && i < nfree; i++){
+            int start, flen;
+            ok = snap_get(p, e, start) && snap_get(p, e, flen)
+              && flen > 0 && snap_range_ok(start, flen, N);
+            if(ok)
+                free_extents[start] = flen;
+        }
+
+        uint32_t ntabs = 0;
+        ok = ok && snap_get(p, e, ntabs);
+        vector<ExtentTable*> tabs;
+        for(uint32_t i = 0; ok && i < ntabs; i++){
+            ExtentTable* t = alloc_table();
+            t->refs = 0;
+            tabs.push_back(t);
+            uint32_t next = 0;
+            ok = snap_get(p, e, next);
+            for(uint32_t x = 0; ok && x < next; x++){
+                int start, xlen;
+                ok = snap_get(p, e, start) && snap_get(p, e, xlen)
+                  && xlen > 0 && snap_range_ok(start, xlen, N);
+                if(ok){
+                    t->ext_off.push_back(t->extents.empty() ? 0 : t->ext_off.back() + t->extents.back().second);
+                    t->extents.push_back({start, xlen});
+                }
+            }
+        }
+
+        uint32_t nfiles = 0;
+        ok = ok && snap_get(p, e, nfiles);
+        for(uint32_t i = 0; ok && i < nfiles; i++){
+            string fname;
+            int fsz = 0;
+            uint32_t tid = 0;
+            ok = snap_get_str(p, e, fname) && snap_get(p, e, fsz) && snap_get(p, e, tid)
+              && snap_range_ok(0, fsz, N) && tid < tabs.size();
+            if(!ok)
+                break;
+            File* fp = alloc_file(fsz);
+            fp->name = fname;
+            fp->tab = tabs[tid];
+            fp->tab->refs++;
+            file_map.insert(fname, fp);
+        }
+
+        munmap((void*)base, len);
+        if(!ok)
+            cerr << "IndexedFileSystem::load_snapshot() : snapshot " << path << " is corrupt\n";
+        return ok;
+    }
+
+    /**
+     * @brief Creates a file of given size. Allocates non contiguous blocks of memory.
+     * 
+     * @param filename name of the file.
+     * @param filesize size of the file.
+     */
+    void create(string filename, int size){
+        StatsTimer _t(stats.create_ns);
+        if constexpr (fs_stats_enabled)
+            stats.creates++;
+        size_t buckets = file_map.bucket_count();
+        if(file_map.find(filename)){
+            cerr << "IndexedFileSystem::create() : Filename already taken\n";
+            return;
+        }
+
+        // bounded-metadata mode : refuse growth once host metadata passes the cap.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "IndexedFileSystem::create() : metadata budget exceeded, cannot create " << filename << "\n";
+            return;
+        }
+
+        // if more blocks are required than it is available, return.
+        if(free_count < size){
+            cerr << "IndexedFileSystem::create() : cannot allocate " << size << " blocks for " << filename << "\n";
+            return;
+        }
+
+        File* fp = alloc_file(size);
+        fp->tab = alloc_table();
+
+        //carve runs off the free store and record them as extents.
+        int remaining = size;
+        while(remaining > 0){
+            int len;
+            int start = alloc_run(remaining, len);
+            append_extent(fp, start, len);
+            remaining -= len;
+        }
+
+        used_memory += size;
+        fp->name = filename;
+        file_map.insert(filename, fp);
+        if constexpr (fs_stats_enabled)
+            if(file_map.bucket_count() != buckets)
+                stats.rehashes++;
+        if(fs_summary(verbosity) && !fp->tab->extents.empty())
+            cout << "IndexedFileSystem::create() : file " << filename << " created starting block " << fp->tab->extents[0].first << endl;
+    }
+
+    /**
+     * @brief creates a batch of files in one call.
+     *
+     * creates pop runs straight off the extent free store, one pop per
+     * extent and no scanning, so the batch is applied in order; callers on
+     * the concurrent wrapper get the whole burst under one lock.
+     *
+     * @param files name/size pairs to create.
+     * @return int - number of files actually created.
+     */
+    int create_batch(const vector<pair<string, int>>& files){
+        size_t before = file_map.size();
+        for(auto& f : files)
+            create(f.first, f.second);
+        return file_map.size() - before;
+    }
+
+    /**
+     * @brief deletes a batch of files in one call, coalescing as it goes.
+     *
+     * @param filenames files to delete.
+     * @return int - number of files deleted.
+     */
+    int delete_batch(const vector<string>& filenames){
+        size_t before = file_map.size();
+        for(auto& name : filenames)
+            delete_file(name);
+        return before - file_map.size();
+    }
+
+    /**
+     * @brief creates dstname as a copy-on-write clone of srcname.
+     *
+     * the clone shares the source's extent table - and therefore its blocks -
+     * so the cost is metadata only; whichever side writes first buys its own
+     * private copy of the blocks.
+     *
+     * @param srcname existing file to clone.
+     * @param dstname name of the clone.
+     */
+    void clone_file(string srcname, string dstname){
+        StatsTimer _t(stats.create_ns);
+        File* src = file_map.find(srcname);
+        if(!src){
+            cerr << "IndexedFileSystem::clone_file() : File " << srcname << " not found\n";
+            return;
+        }
+        if(file_map.find(dstname)){
+            cerr << "IndexedFileSystem::clone_file() : Filename already taken\n";
+            return;
+        }
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "IndexedFileSystem::clone_file() : metadata budget exceeded, cannot clone " << srcname << "\n";
+            return;
+        }
+        if constexpr (fs_stats_enabled)
+            stats.creates++;
+        File* fp = alloc_file(src->filesize);
+        fp->name = dstname;
+        fp->tab = src->tab;
+        fp->tab->refs++;
+        file_map.insert(dstname, fp);
+        if(fs_summary(verbosity))
+            cout << "IndexedFileSystem::clone_file() : " << dstname << " cloned from " << srcname << endl;
+    }
+
+    /**
+     * @brief forks the whole namespace under tag/, sharing every block.
+     *
+     * every live file gets a copy-on-write clone named tag/<path>, so a
+     * what-if experiment runs against the fork for metadata cost only and
+     * is thrown away with delete_tree(tag) - no replay involved.
+     *
+     * @param tag directory the fork lives under.
+     * @return int - number of files cloned.
+     */
+    int snapshot(const string& tag){
+        // collect first : cloning mutates the namespace being walked.
+        vector<File*> live;
+        file_map.for_each([&](File* fp){ live.push_back(fp); });
+        int made = 0;
+        for(File* src : live){
+            string dst = tag + "/" + src->name;
+            if(file_map.find(dst)){
+                cerr << "IndexedFileSystem::snapshot() : Filename " << dst << " already taken\n";
+                continue;
+            }
+            if constexpr (fs_stats_enabled)
+                stats.creates++;
+            File* fp = alloc_file(src->filesize);
+            fp->name = dst;
+            fp->tab = src->tab;
+            fp->tab->refs++;
+            file_map.insert(dst, fp);
+            made++;
+        }
+        if(fs_summary(verbosity))
+            cout << "IndexedFileSystem::snapshot() : " << made << " files forked under " << tag << endl;
+        return made;
+    }
+
+    /**
+     * @brief resolves a filename to a small integer handle for the hot-path overloads.
+     *
+     * The handle stays valid until the file is deleted; opening the same file
+     * again returns the same handle.
+     *
+     * @param filename name of the file.
+     * @return int - file handle, -1 if the file does not exist.
+     */
+    int open_file(const string& filename){
+        File* fp = file_map.find(filename);
+        if(!fp)
+            return -1;
+        if(fp->handle == -1){
+            fp->handle = handles.size();
+            handles.push_back(fp);
+        }
+        return fp->handle;
+    }
+
+    /**
+     * @brief reads 'size' blocks of the file from given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to read.
+     * @param offset block number to start reading.
+     * @return int - number of block accesses taken to read the file.
+     */
+    int read(string filename, int size = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "IndexedAllocation::read() : File " << filename << " not found\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    /**
+     * @brief reads by file handle, skipping the name lookup.
+     */
+    int read(int fd, int size = -1, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "IndexedAllocation::read() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    private:
+
+    int read_file(File* fp, int size, int offset){
+        int block_access = 1;
+
+        size = (size == -1) ? fp->filesize : size;
+        int read = 0;
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the index lookup.
+        int prev = INT_MIN;
+
+        // iterate through the extents from the offset.
+        for(int i = offset; i < fp->filesize && read < size; i++){
+            int b = block_at(fp, i);
+            if(fs_trace(verbosity))
+                cout << "IndexedAllocation::read() : Reading block " << b << endl;
+            read++;
+            bool hit = cache && cache->access(b);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, b, hit);
+        }
+        last_io = io;
+
+        if(fs_summary(verbosity))
+            cout << "IndexedAllocation::read() : Total blocks read : " << read << endl;
+
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief writes 'size' blocks starting from the given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to write.
+     * @param offset starting block to write from.
+     * @return int - number of block accesses taken to write the file
+     */
+    int write(string filename, int size, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "IndexedFileSystem::write() : File " << filename << " not found\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    /**
+     * @brief writes by file handle, skipping the name lookup.
+     */
+    int write(int fd, int size, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "IndexedFileSystem::write() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    private:
+
+    /**
+     * @brief gives a file sharing its index table a private copy of the blocks.
+     *
+     * allocates fresh runs for the whole file, copies the bytes when the
+     * data plane is live and drops the reference on the shared table.
+     *
+     * @param fp the file.
+     * @return int - blocks copied, 0 when the table was already private, -1
+     * when memory for the copy cannot be allocated.
+     */
+    int materialize(File* fp){
+        if(fp->tab->refs == 1)
+            return 0;
+        if(free_count < fp->filesize){
+            cerr << "IndexedFileSystem::write() : cannot allocate private copy for " << fp->name << "\n";
+            return -1;
+        }
+        ExtentTable* shared = fp->tab;
+
+        // bytes first : the copy needs views over both tables at once.
+        vector<char> bytes;
+        if(!store.empty() && fp->filesize > 0){
+            bytes.resize((size_t)fp->filesize * FS_BLOCK_SIZE);
+            gather_bytes(runs_to_views(store_base(), shared->extents, 0, (int)bytes.size()), bytes.data());
+        }
+
+        fp->tab = alloc_table();
+        int remaining = fp->filesize;
+        while(remaining > 0){
+            int len;
+            int start = alloc_run(remaining, len);
+            append_extent(fp, start, len);
+            remaining -= len;
+        }
+        if(!bytes.empty())
+            scatter_bytes(runs_to_views(store_base(), fp->tab->extents, 0, (int)bytes.size()), bytes.data());
+
+        shared->refs--;
+        used_memory += fp->filesize;
+        if(fs_summary(verbosity))
+            cout << "IndexedFileSystem::write() : " << fp->name << " materialized private copy of " << fp->filesize << " blocks" << endl;
+        return fp->filesize;
+    }
+
+    int write_file(File* fp, int size, int offset){
+        int block_access = 1;
+        int written = 0;
+        int bno = offset;
+
+        // clones share their index table; the first write buys this file its
+        // own blocks, charged one read and one write per copied block.
+        int copied = materialize(fp);
+        if(copied < 0)
+            return block_access;
+        block_access += 2 * copied;
+
+        // if more overflow blocks are required than it is available, return.
+        if(offset + size > fp->filesize && offset + size - fp->filesize  > free_count){
+            cerr << "IndexedFileSystem::write() : cannot allocate memory for write\n";
+            return block_access;
+        }
+
+        // grow the file by whole runs first if the write goes past the end.
+        if(offset + size > fp->filesize){
+            int need = offset + size - fp->filesize;
+            while(need > 0){
+                int len;
+                int start = alloc_run(need, len);
+                for(int k = 0; k < len; k++)
+                    if(fs_trace(verbosity))
+                        cout << "IndexedFileSystem::write() : Allocating new block " << start + k << endl;
+                append_extent(fp, start, len);
+                fp->filesize += len;
+                used_memory += len;
+                need -= len;
+            }
+        }
+
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the index lookup.
+        int prev = INT_MIN;
+        while(written < size){
+            int b = block_at(fp, bno);
+            if(fs_trace(verbosity))
+                cout << "IndexedFileSystem::write() : Writing block " << b << endl;
+            bool hit = cache && cache->access(b);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, b, hit);
+            written++;
+            bno++;
+        }
+        last_io = io;
+
+        if(fs_summary(verbosity))
+            cout << "IndexedFileSystem::write() : Total blocks written : " << written << endl;
+
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief removes the given file from the filesystem.
+     *
+     * @param filename name of the file.
+     */
+    void delete_file(string filename){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "IndexedFleSystem::delete() : File not found.\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes by file handle, skipping the name lookup.
+     */
+    void delete_file(int fd){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "IndexedFleSystem::delete() : bad file handle " << fd << "\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes every file under the given directory in one pass.
+     *
+     * the subtree is unlinked from the namespace once and each file's
+     * resources are then reaped, so the cost is O(files under dirname)
+     * rather than a scan of the whole namespace.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return int - number of files deleted.
+     */
+    int delete_tree(string dirname){
+        int removed = file_map.erase_under(dirname, [&](File* fp){ drop_file(fp); });
+        if(fs_summary(verbosity))
+            cout << "IndexedFileSystem::delete_tree() : " << removed << " files deleted under " << dirname << endl;
+        return removed;
+    }
+
+    /**
+     * @brief full names of every file under the given directory.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return vector<string> - the files' full paths.
+     */
+    vector<string> list_dir(string dirname){
+        vector<string> out;
+        file_map.for_each_under(dirname, [&](File* fp){ out.push_back(fp->name); });
+        return out;
+    }
+
+    private:
+
+    // namespace removal and resource teardown are separate so the
+    // subtree delete can unlink a whole directory once and reap per file.
+    void delete_fp(File* fp){
+        file_map.erase(fp->name);
+        drop_file(fp);
+    }
+
+    void drop_file(File* fp){
+        // return each extent to the free store, coalescing as it goes.
+        StatsTimer _t(stats.delete_ns);
+        if constexpr (fs_stats_enabled)
+            stats.deletes++;
+        // a shared table keeps its blocks until the last clone goes.
+        fp->tab->refs--;
+        if(fp->tab->refs == 0){
+            if(fs_summary(verbosity))
+                cout << "IndexedFleSystem::delete() : deallocating file blocks\n";
+            for(auto& e : fp->tab->extents)
+                free_run(e.first, e.second);
+            used_memory -= fp->filesize;
+            release_table(fp->tab);
+        }
+
+        if(fp->handle != -1)
+            handles[fp->handle] = nullptr;
+        if(fs_summary(verbosity))
+            cout << "IndexedFleSystem::delete() : File " << fp->name << " deleted\n";
+        release_file(fp);
+    }
+
+    public:
+
+    /**
+     * @brief Get the storage efficiency of the file system.
+     * 
+     * @return float - returns the ratio of used memory to the total memory size.
+     */
+    float get_storage_efficiency(){
+        return (float)used_memory/N;
+    }
+
+    /**
+     * @brief estimated host-heap bytes behind this instance, by structure.
+     *
+     * extent tables are the per-file cost : clones share one table, so a
+     * heavily forked namespace is cheaper than the file count suggests.
+     */
+    MemoryFootprint get_memory_footprint(){
+        MemoryFootprint f;
+        f.block_store = store.capacity();
+        f.file_records = deque_heap_bytes(slab) + vec_heap_bytes(slab_free)
+                       + deque_heap_bytes(tab_slab) + vec_heap_bytes(tab_free);
+        for(const File& rec : slab)
+            f.file_records += string_heap_bytes(rec.name);
+        for(const ExtentTable& t : tab_slab)
+            f.file_records += vec_heap_bytes(t.extents) + vec_heap_bytes(t.ext_off);
+        f.free_lists = map_heap_bytes(free_extents);
+        f.name_map = file_map.footprint() + vec_heap_bytes(handles);
+        if(f.total() > mem_high_water)
+            mem_high_water = f.total();
+        return f;
+    }
+
+    /**
+     * @brief bounded-metadata mode : creates fail once the footprint
+     * passes the budget. 0 (the default) lifts the cap.
+     */
+    void set_metadata_budget(size_t bytes){
+        metadata_budget = bytes;
+    }
+
+    /**
+     * @brief largest footprint total observed so far; refreshed here and
+     * by every budget check and get_memory_footprint() call.
+     */
+    size_t get_metadata_high_water(){
+        get_memory_footprint();
+        return mem_high_water;
+    }
+
+};
+
+/**
+ * @brief A file system that allocates initial contiguous block. contiguous overflow blocks are linked. Inherits from ContiguousFileSystem
+ * 
+ * @tparam N size of the memory
+ */
+template<size_t N=1024>
+class ModifiedContiguousFileSystem : public ContiguousFileSystem<N>{
+    private:
+    struct block{
+        int start_block;
+        int size;
+        block* next;
+        block(int strt, int sz, block* nxt = nullptr){
+            start_block = strt;
+            size = sz;
+            next = nxt;
+        }
+    };
+    class File{
+        int filesize;
+        block* start;
+        string name;      // so handle-based deletes can erase the map entry.
+        int handle = -1;  // slot in the handle table, -1 while unopened.
+        File(int filesize, block* start) : filesize(filesize), start(start) {}
+        friend class ModifiedContiguousFileSystem;
+    };
+
+    DirTree<File> file_map;
+    vector<File*> handles;  // open-handle table; slots of deleted files are nulled.
+
+    /**
+     * @brief resolves a handle back to its file, nullptr for stale or bad handles.
+     */
+    File* handle_file(int fd){
+        if(fd < 0 || fd >= (int)handles.size())
+            return nullptr;
+        return handles[fd];
+    }
+
+    // slabs for File records and chunk nodes : both stored by value in deques
+    // so addresses stay stable, with freed slots recycled through freelists.
+    // no per-file or per-chunk new/delete, and teardown is the deques dying.
+    deque<File> slab;
+    vector<File*> slab_free;
+    deque<block> bslab;
+    vector<block*> bslab_free;
+
+    size_t metadata_budget = 0;  // host bytes allowed for metadata, 0 = unbounded.
+    size_t mem_high_water = 0;   // largest footprint total seen so far.
+
+    /**
+     * @brief takes a File record off the slab, reusing a freed slot if any.
+     */
+    File* alloc_file(int filesize, block* start){
+        if(!slab_free.empty()){
+            File* fp = slab_free.back();
+            slab_free.pop_back();
+            *fp = File(filesize, start);
+            return fp;
+        }
+        slab.push_back(File(filesize, start));
+        return &slab.back();
+    }
+
+    /**
+     * @brief returns a dead File record's slot to the slab freelist.
+     */
+    void release_file(File* fp){
+        slab_free.push_back(fp);
+    }
+
+    /**
+     * @brief takes a chunk node off the block slab.
+     */
+    block* alloc_block(int start, int size){
+        if(!bslab_free.empty()){
+            block* b = bslab_free.back();
+            bslab_free.pop_back();
+            *b = block(start, size);
+            return b;
+        }
+        bslab.push_back(block(start, size));
+        return &bslab.back();
+    }
+
+    /**
+     * @brief returns a dead chunk node's slot to the block slab freelist.
+     */
+    void release_block(block* b){
+        bslab_free.push_back(b);
+    }
+
+    public: 
+    ModifiedContiguousFileSystem(typename ContiguousFileSystem<N>::Strategy alg = ContiguousFileSystem<N> :: FIRST_FIT)
+        : ContiguousFileSystem<N>(alg == ContiguousFileSystem<N>::BUDDY ? ContiguousFileSystem<N>::FIRST_FIT : alg){
+        // overflow chunks are freed piecemeal at exact sizes, which buddy
+        // chunks cannot be; fall back to first-fit instead.
+        if(alg == ContiguousFileSystem<N>::BUDDY)
+            cerr << "ModifiedContigousFileSystem : BUDDY is not supported, using FIRST_FIT\n";
+    }
+
+    // movable like the base, and not copyable for the same reason.
+    ModifiedContiguousFileSystem(ModifiedContiguousFileSystem&&) = default;
+    ModifiedContiguousFileSystem(const ModifiedContiguousFileSystem&) = delete;
+
+    /**
+     * @brief Creates a file of given size. Allocates contiguous linked blocks of memory.
+     * 
+     * @param filename name of the file.
+     * @param filesize size of the file.
+     */
+    void create(string filename, int filesize) {
+        StatsTimer _t(this->stats.create_ns);
+        if constexpr (fs_stats_enabled)
+            this->stats.creates++;
+        size_t buckets = file_map.bucket_count();
+        if(file_map.find(filename)){
+            cerr << "ModifiedContiguousFileSystem::create() : Filename already taken\n";
+            return;
+        }
+
+        // bounded-metadata mode : refuse growth once host metadata passes the cap.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "ModifiedContiguousFileSystem::create() : metadata budget exceeded, cannot create " << filename << "\n";
+            return;
+        }
+
+        // a zero-size file owns no chunk : the free scan would hand back a
+        // used block for it (a zero run fits anywhere).
+        if(filesize <= 0){
+            File* fp = alloc_file(0, nullptr);
+            fp->name = filename;
+            file_map.insert(filename, fp);
+            if constexpr (fs_stats_enabled)
+                if(file_map.bucket_count() != buckets)
+                    this->stats.rehashes++;
+            return;
+        }
+
+        // get the start index of allotted chunk.
+        int start = this->get_index(filesize);
+
+        // if it is not possible to allot contiguous chunk return.
+        if(start == -1){
+            cerr << "ModifiedContiguousFileSystem::create() : Can't allocate " << filesize << " blocks for file " << filename << "\n";
+            return;
+        }
+
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContiguousFileSystem::create() : File created starting block - " << start << endl;
+
+        // mark the allotted blocks as used.
+        this->allocate_extent(start, filesize);
+
+        this->used_memory += filesize;
+        File* fp = alloc_file(filesize, alloc_block(start, filesize));
+        fp->name = filename;
+        file_map.insert(filename, fp);
+        if constexpr (fs_stats_enabled)
+            if(file_map.bucket_count() != buckets)
+                this->stats.rehashes++;
+        return;
+    }
+
+    /**
+     * @brief creates a batch of files in one call.
+     *
+     * chunked allocation falls back through halving sizes per file, which
+     * does not compose into one planning pass, so the batch applies the
+     * creates in order against this class's own namespace.
+     *
+     * @param files name/size pairs to create.
+     * @return int - number of files actually created.
+     */
+    int create_batch(const vector<pair<string, int>>& files){
+        size_t before = file_map.size();
+        for(auto& f : files)
+            create(f.first, f.second);
+        return file_map.size() - before;
+    }
+
+    /**
+     * @brief deletes a batch of files in one call.
+     *
+     * @param filenames files to delete.
+     * @return int - number of files deleted.
+     */
+    int delete_batch(const vector<string>& filenames){
+        size_t before = file_map.size();
+        for(auto& name : filenames)
+            delete_file(name);
+        return before - file_map.size();
+    }
+
+    /**
+     * @brief resolves a filename to a small integer handle for the hot-path overloads.
+     *
+     * The handle stays valid until the file is deleted; opening the same file
+     * again returns the same handle.
+     *
+     * @param filename name of the file.
+     * @return int - file handle, -1 if the file does not exist.
+     */
+    int open_file(const string& filename){
+        File* fp = file_map.find(filename);
+        if(!fp)
+            return -1;
+        if(fp->handle == -1){
+            fp->handle = handles.size();
+            handles.push_back(fp);
+        }
+        return fp->handle;
+    }
+
+    /**
+     * @brief writes the filesystem metadata to a flat binary snapshot.
+     *
+     * The per-file chunk chains are flattened to (start, size) arrays.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool save_snapshot(const string& path){
+        ofstream out(path, ios::binary);
+        if(!out){
+            cerr << "ModifiedContiguousFileSystem::save_snapshot() : cannot open " << path << "\n";
+            return false;
+        }
+        out.write(SNAP_MAGIC, sizeof(SNAP_MAGIC));
+        out.put('M');
+        this->save_core(out);
+        uint32_t nfiles = file_map.size();
+        snap_put(out, nfiles);
+        file_map.for_each([&](File* fp){
+            snap_put_str(out, fp->name);
+            snap_put(out, fp->filesize);
+            uint32_t nchunks = 0;
+            for(block* b = fp->start; b; b = b->next)
+                nchunks++;
+            snap_put(out, nchunks);
+            for(block* b = fp->start; b; b = b->next){
+                snap_put(out, b->start_block);
+                snap_put(out, b->size);
+            }
+        });
+        return out.good();
+    }
+
+    /**
+     * @brief restores the filesystem metadata from a snapshot, replacing all state.
+     *
+     * Open handles do not survive a load.
+     *
+     * @param path snapshot file.
+     * @return true on success.
+     */
+    bool load_snapshot(const string& path){
+        size_t len;
+        const char* p;
+        const char* base = snap_map(path.c_str(), 'M', len, p);
+        if(!base){
+            cerr << "ModifiedContiguousFileSystem::load_snapshot() : cannot load " << path << "\n";
+            return false;
+        }
+        const char* e = base + len;
+
+        file_map.clear();
+        handles.clear();
+        slab.clear();
+        slab_free.clear();
+        bslab.clear();
+        bslab_free.clear();
+
+        bool ok = this->load_core(p, e);
+
+        uint32_t nfiles = 0;
+        ok = ok && snap_get(p, e, nfiles);
+        for(uint32_t i = 0; ok && i < nfiles; i++){
+            string fname;
+            int fsz = 0;
+            uint32_t nchunks = 0;
+            ok = snap_get_str(p, e, fname) && snap_get(p, e, fsz) && snap_get(p, e, nchunks)
+              && snap_range_ok(0, fsz, N);
+            if(!ok)
+                break;
+            block* head = nullptr;
+            block* tail = nullptr;
+            for(uint32_t c = 0; ok && c < nchunks; c++){
+                int start, csz;
+                ok = snap_get(p, e, start) && snap_get(p, e, csz)
+                  && csz > 0 && snap_range_ok(start, csz, N);
+                if(ok){
+                    block* b = alloc_block(start, csz);
+                    if(tail)
+                        tail->next = b;
+                    else
+                        head = b;
+                    tail = b;
+                }
+            }
+            if(ok){
+                File* fp = alloc_file(fsz, head);
+                fp->name = fname;
+                file_map.insert(fname, fp);
+            }
+            else{
+                while(head){
+                    block* next = head->next;
+                    release_block(head);
+                    head = next;
+                }
+            }
+        }
+
+        munmap((void*)base, len);
+        if(!ok)
+            cerr << "ModifiedContiguousFileSystem::load_snapshot() : snapshot " << path << " is corrupt\n";
+        return ok;
+    }
+
+    /**
+     * @brief writes 'size' blocks starting from the given offset. contiguous blocks are alloted and linked to the file.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to write.
+     * @param offset starting block to write from.
+     * @return int - number of block accesses taken to write the file
+     */
+    int write(string filename, int size, int offset) {
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ModifiedContiguousFileSystem::write() : File " << filename << " not found\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    /**
+     * @brief writes by file handle, skipping the name lookup.
+     */
+    int write(int fd, int size, int offset) {
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ModifiedContiguousFileSystem::write() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    private:
+
+    int write_file(File* fp, int size, int offset) {
+        int block_access = 1;
+        block* newblock = nullptr;
+        if(size + offset > fp->filesize){
+            // check if a contiguous chunk can be allotted for the overflow data.
+            int req = size + offset - fp->filesize;
+
+            int index = this->get_index(req);
+
+            if(index == -1){
+                cerr << "ModifiedContiguousFileSystem::write() : cannot allocate overflow blocks\n";
+                return block_access;
+            }
+
+            // if possible, mark the blocks as used.
+            this->allocate_extent(index, req);
+
+            newblock = alloc_block(index, req);
+
+            fp->filesize += req; 
+
+            this->used_memory += req;
+        }
+
+        int bno = 0, written = 0;
+        block* b = fp->start;
+        block* last = nullptr;
+        IoResult io;
+        io.cost = this->cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
+
+        while(b && written < size){
+            block_access++;
+            io.cost += this->cost_model.seek_cost;  // chunk header touch.
+            if(offset >= bno && offset < bno + b->size){
+                int wrt = offset-bno;
+                if(wrt == 0){
+                    // the header touch coincides with the first data block.
+                    block_access--;
+                    io.cost -= this->cost_model.seek_cost;
+                }
+                for(int i = wrt; i < b->size && written != size; i++){
+                    if(fs_trace(this->verbosity))
+                        cout << "ModifiedContiguousFileSystem::write() : Writing block " << b->start_block + i << endl;
+                    bool hit = this->cache && this->cache->access(b->start_block + i);
+                    if(!hit)
+                        block_access++;
+                    charge_touch(this->cost_model, io, prev, b->start_block + i, hit);
+                    written++;
+                }
+                offset += written;
+            }
+            bno += b->size;
+            last = b;
+            b = b->next;
+        }
+
+        if(newblock){
+            if(fs_trace(this->verbosity))
+                cout << "ModifiedContiguousFileSystem::write() : Allocating overflow blocks\n" ;
+            for(int i = 0; i < newblock->size; i++){
+                if(fs_trace(this->verbosity))
+                    cout << "ModifiedContiguousFileSystem::write() : Writing block " << newblock->start_block + i << endl;
+                bool hit = this->cache && this->cache->access(newblock->start_block + i);
+                if(!hit)
+                    block_access++;
+                charge_touch(this->cost_model, io, prev, newblock->start_block + i, hit);
+                written++;
+            }
+            if(last)
+                last->next = newblock;
+            else
+                fp->start = newblock;  // first chunk of a zero-size file.
+        }
+
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContiguousFileSystem::write() : Total blocks written : " << written << endl;
+
+        this->last_io = io;
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief reads 'size' blocks of the file from given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to read.
+     * @param offset block number to start reading.
+     * @return int - number of block accesses taken to read the file.
+     */
+    int read(string filename, int size=-1, int offset = 0) {
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ModifiedContigousFileSystem::read() : File " << filename << " not found\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    /**
+     * @brief reads by file handle, skipping the name lookup.
+     */
+    int read(int fd, int size=-1, int offset = 0) {
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ModifiedContigousFileSystem::read() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    private:
+
+    int read_file(File* fp, int size, int offset) {
+        int block_access = 1;
+
+        size = (size==-1) ? fp->filesize : size;
+
+        int read = 0, bno = 0;
+        block* b = fp->start;
+        IoResult io;
+        io.cost = this->cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
+
+        // find the block where the offset block is present and start reading.
+        while(b && read < size){
+            block_access++;
+            io.cost += this->cost_model.seek_cost;  // chunk header touch.
+            if(offset >= bno && offset < bno + b->size){
+                int rd = offset - bno;
+                if(rd == 0){
+                    // the header touch coincides with the first data block.
+                    block_access--;
+                    io.cost -= this->cost_model.seek_cost;
+                }
+                for(int i = rd; i < b->size && read < size; i++){
+                    if(fs_trace(this->verbosity))
+                        cout << "ModifiedContigousFileSystem::read() : Reading block " << b->start_block + i << endl;
+                    bool hit = this->cache && this->cache->access(b->start_block + i);
+                    if(!hit)
+                        block_access++;
+                    charge_touch(this->cost_model, io, prev, b->start_block + i, hit);
+                    read++;
+                }
+                offset += read;
+            }
+            bno += b->size;
+            b = b->next;
+        }
+
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContigousFileSystem::read() : Total blocks read : " << read << endl;
+
+        this->last_io = io;
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief returns zero-copy views over the file's bytes in [offset, offset+len).
+     *
+     * one view per chunk of the file; the backing store is shared with the
+     * base class, so the chunk runs index straight into it.
+     *
+     * @param filename name of the file.
+     * @param len number of bytes, -1 for everything from the offset on.
+     * @param offset starting byte within the file.
+     * @return views into the backing store, empty on error.
+     */
+    vector<BlockView> map_file(string filename, int len = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "ModifiedContigousFileSystem::map_file() : File " << filename << " not found\n";
+            return {};
+        }
+        return map_views(fp, len, offset);
+    }
+
+    /**
+     * @brief copies the file's bytes in [offset, offset+len) into buf.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int read(string filename, char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return gather_bytes(views, buf);
+    }
+
+    /**
+     * @brief copies len bytes of buf into the file at the given byte offset.
+     *
+     * the write must fit inside the file's allocated blocks; the data plane
+     * never grows a file.
+     *
+     * @return int - bytes copied, -1 on error.
+     */
+    int write(string filename, const char* buf, int len, int offset = 0){
+        auto views = map_file(filename, len, offset);
+        if(views.empty() && len != 0)
+            return -1;
+        return scatter_bytes(views, buf);
+    }
+
+    private:
+
+    /**
+     * @brief clips a byte range against the file and builds its view list.
+     */
+    vector<BlockView> map_views(File* fp, int len, int offset){
+        int limit = fp->filesize * (int)FS_BLOCK_SIZE;
+        if(len == -1)
+            len = limit - offset;
+        if(offset < 0 || len < 0 || offset + len > limit){
+            cerr << "ModifiedContigousFileSystem::map_file() : byte range past end of file\n";
+            return {};
+        }
+        if(len == 0)
+            return {};
+        vector<pair<int, int>> runs;
+        for(block* b = fp->start; b; b = b->next)
+            runs.push_back({b->start_block, b->size});
+        return runs_to_views(this->store_base(), runs, offset, len);
+    }
+
+    public:
+
+    /**
+     * @brief removes the given file from the filesystem.
+     *
+     * @param filename name of the file.
      */
     void delete_file(string filename) {
-        if(file_map.find(filename) == file_map.end()){
+        File* fp = file_map.find(filename);
+        if(!fp){
             cerr << "ModifiedContigousFileSystem::delete(): File not found.\n";
             return;
         }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes by file handle, skipping the name lookup.
+     */
+    void delete_file(int fd) {
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "ModifiedContigousFileSystem::delete(): bad file handle " << fd << "\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes every file under the given directory in one pass.
+     *
+     * the subtree is unlinked from the namespace once and each file's
+     * resources are then reaped, so the cost is O(files under dirname)
+     * rather than a scan of the whole namespace.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return int - number of files deleted.
+     */
+    int delete_tree(string dirname){
+        int removed = file_map.erase_under(dirname, [&](File* fp){ drop_file(fp); });
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContigousFileSystem::delete_tree() : " << removed << " files deleted under " << dirname << endl;
+        return removed;
+    }
+
+    /**
+     * @brief full names of every file under the given directory.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return vector<string> - the files' full paths.
+     */
+    vector<string> list_dir(string dirname){
+        vector<string> out;
+        file_map.for_each_under(dirname, [&](File* fp){ out.push_back(fp->name); });
+        return out;
+    }
+
+    private:
+
+    // namespace removal and resource teardown are separate so the
+    // subtree delete can unlink a whole directory once and reap per file.
+    void delete_fp(File* fp){
+        file_map.erase(fp->name);
+        drop_file(fp);
+    }
+
+    void drop_file(File* fp) {
+        StatsTimer _t(this->stats.delete_ns);
+        if constexpr (fs_stats_enabled)
+            this->stats.deletes++;
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContigousFileSystem::delete() : deallocating block\n";
+        block* b = fp->start;
+
+        //iterate through each chunk, marking each block in the chunk as free.
+        while(b){
+            this->free_extent(b->start_block, b->size);
+            block* next = b->next;
+            release_block(b);
+            b = next;
+        }
+        
+        if(fp->handle != -1)
+            handles[fp->handle] = nullptr;
+        this->used_memory -= fp->filesize;
+        if(fs_summary(this->verbosity))
+            cout << "ModifiedContigousFileSystem::delete() : " << fp->name << " deleted\n";
+        release_file(fp);
+    }
+
+    public:
+
+    /**
+     * @brief estimated host-heap bytes behind this instance, by structure.
+     *
+     * the base class covers the bitmap, summary tree and hole index; the
+     * chunk slabs and this class's own namespace go on top.
+     */
+    MemoryFootprint get_memory_footprint(){
+        MemoryFootprint f = ContiguousFileSystem<N>::get_memory_footprint();
+        f.file_records += deque_heap_bytes(slab) + vec_heap_bytes(slab_free)
+                        + deque_heap_bytes(bslab) + vec_heap_bytes(bslab_free);
+        for(const File& rec : slab)
+            f.file_records += string_heap_bytes(rec.name);
+        f.name_map += file_map.footprint() + vec_heap_bytes(handles);
+        if(f.total() > mem_high_water)
+            mem_high_water = f.total();
+        return f;
+    }
+
+    /**
+     * @brief bounded-metadata mode : creates fail once the footprint
+     * passes the budget. 0 (the default) lifts the cap.
+     */
+    void set_metadata_budget(size_t bytes){
+        metadata_budget = bytes;
+    }
+
+    /**
+     * @brief largest footprint total observed so far; refreshed here and
+     * by every budget check and get_memory_footprint() call.
+     */
+    size_t get_metadata_high_water(){
+        get_memory_footprint();
+        return mem_high_water;
+    }
+};
+
+
+/**
+ * @brief A file system that allocates one contiguous extent when it can and
+ * falls back to an extent-indexed layout when fragmentation denies one.
+ *
+ * Every create tries a single best-fit run first; only when no free run is
+ * large enough - the bitmap is fragmented past the point where a contiguous
+ * placement exists - does the file become a multi-extent index, carved from
+ * the largest runs to keep the extent count low. The layout is recorded per
+ * file, so reads on contiguous files are plain offset arithmetic and only
+ * fragmented files pay for the index lookup.
+ *
+ * @tparam N size of the memory.
+ */
+template<size_t N = 1024>
+class HybridFileSystem{
+    public:
+
+    enum Layout : uint8_t { EXTENT, INDEXED };
+
+    private:
+
+    class File {
+        int filesize;
+        Layout layout = EXTENT;
+        // single entry for EXTENT files; (start, length) runs with cumulative
+        // logical offsets for binary search once the file goes INDEXED.
+        vector<pair<int, int>> extents;
+        vector<int> ext_off;
+        string name;      // so handle-based deletes can erase the map entry.
+        int handle = -1;  // slot in the handle table, -1 while unopened.
+        File(int filesize) : filesize(filesize) {}
+        friend class HybridFileSystem;
+    };
+
+    DirTree<File> file_map;
+    vector<File*> handles;  // open-handle table; slots of deleted files are nulled.
+
+    /**
+     * @brief resolves a handle back to its file, nullptr for stale or bad handles.
+     */
+    File* handle_file(int fd){
+        if(fd < 0 || fd >= (int)handles.size())
+            return nullptr;
+        return handles[fd];
+    }
+
+    FsStats stats;
+    CostModel cost_model;
+    AtomicIoResult last_io;
+
+    size_t metadata_budget = 0;  // host bytes allowed for metadata, 0 = unbounded.
+    size_t mem_high_water = 0;   // largest footprint total seen so far.
+
+    // slab of File records : stored by value in a deque so addresses stay
+    // stable for a record's whole life, with freed slots recycled through a
+    // freelist. no per-file new/delete, and teardown is just the deque dying.
+    deque<File> slab;
+    vector<File*> slab_free;
+
+    File* alloc_file(int size){
+        if(!slab_free.empty()){
+            File* fp = slab_free.back();
+            slab_free.pop_back();
+            *fp = File(size);
+            return fp;
+        }
+        slab.push_back(File(size));
+        return &slab.back();
+    }
+
+    void release_file(File* fp){
+        slab_free.push_back(fp);
+    }
+
+    // free store : runs ordered by start for coalescing, mirrored by length
+    // so the single-extent best fit is one ordered lookup.
+    map<int, int> free_extents;
+    multiset<pair<int, int>> free_by_size;  // (length, start)
+    int free_count;
+    int used_memory;
+    Verbosity verbosity = TRACE;
+    BufferCache* cache = nullptr;
+
+    /**
+     * @brief returns a run of blocks to the free store, coalescing with neighbours.
+     */
+    void free_run(int start, int len){
+        if(len == 0)
+            return;
+        if constexpr (fs_stats_enabled)
+            stats.free_runs = 0;  // refreshed by get_stats.
+        free_count += len;  // before merging grows len by already-free blocks.
+        auto next = free_extents.lower_bound(start);
+        if(next != free_extents.begin()){
+            auto prev = std::prev(next);
+            if(prev->first + prev->second == start){
+                start = prev->first;
+                len += prev->second;
+                free_by_size.erase(free_by_size.find({prev->second, prev->first}));
+                free_extents.erase(prev);
+            }
+        }
+        if(next != free_extents.end() && start + len == next->first){
+            len += next->second;
+            free_by_size.erase(free_by_size.find({next->second, next->first}));
+            free_extents.erase(next);
+        }
+        free_extents[start] = len;
+        free_by_size.insert({len, start});
+    }
+
+    /**
+     * @brief takes the best-fitting single run of exactly size blocks.
+     *
+     * @return int - start of the run, -1 when no free run is large enough.
+     */
+    int take_best(int size){
+        if constexpr (fs_stats_enabled)
+            stats.scan_steps++;
+        auto it = free_by_size.lower_bound({size, INT_MIN});
+        if(it == free_by_size.end())
+            return -1;
+        int len = it->first, start = it->second;
+        free_by_size.erase(it);
+        free_extents.erase(start);
+        if(len > size){
+            free_extents[start + size] = len - size;
+            free_by_size.insert({len - size, start + size});
+        }
+        free_count -= size;
+        return start;
+    }
+
+    /**
+     * @brief carves up to want blocks off the largest free run.
+     *
+     * largest-first keeps the extent count of fragmented files low.
+     *
+     * @param want blocks still needed.
+     * @param len set to the length actually taken.
+     * @return int - start of the run taken.
+     */
+    int carve_largest(int want, int& len){
+        if constexpr (fs_stats_enabled)
+            stats.scan_steps++;
+        auto it = std::prev(free_by_size.end());
+        int rlen = it->first, start = it->second;
+        len = min(want, rlen);
+        free_by_size.erase(it);
+        free_extents.erase(start);
+        if(rlen > len){
+            free_extents[start + len] = rlen - len;
+            free_by_size.insert({rlen - len, start + len});
+        }
+        free_count -= len;
+        return start;
+    }
+
+    /**
+     * @brief appends a run to the file's extent list, merging when adjacent.
+     */
+    void append_extent(File* fp, int start, int len){
+        if(!fp->extents.empty() && fp->extents.back().first + fp->extents.back().second == start){
+            fp->extents.back().second += len;
+            return;
+        }
+        fp->ext_off.push_back(fp->extents.empty() ? 0 : fp->ext_off.back() + fp->extents.back().second);
+        fp->extents.push_back({start, len});
+    }
+
+    /**
+     * @brief physical block holding logical block bno of the file.
+     */
+    int block_at(File* fp, int bno){
+        // the recorded layout picks the cheap path : contiguous files are
+        // plain arithmetic, only fragmented ones binary-search the index.
+        if(fp->layout == EXTENT)
+            return fp->extents[0].first + bno;
+        auto it = std::prev(upper_bound(fp->ext_off.begin(), fp->ext_off.end(), bno));
+        int e = it - fp->ext_off.begin();
+        return fp->extents[e].first + (bno - *it);
+    }
+
+    public:
+
+    HybridFileSystem() : free_count(N), used_memory(0){
+        free_extents[0] = N;
+        free_by_size.insert({(int)N, 0});
+    }
+
+    // file records live by value in a slab owned by the instance, so the
+    // filesystem moves wholesale but must not be copied (the maps hold
+    // pointers into the slab).
+    HybridFileSystem(HybridFileSystem&&) = default;
+    HybridFileSystem(const HybridFileSystem&) = delete;
+
+    /**
+     * @brief Creates a file, contiguous when possible, indexed otherwise.
+     *
+     * @param filename name of the file.
+     * @param size size of the file.
+     */
+    void create(string filename, int size){
+        StatsTimer _t(stats.create_ns);
+        if constexpr (fs_stats_enabled)
+            stats.creates++;
+        size_t buckets = file_map.bucket_count();
+        if(file_map.find(filename)){
+            cerr << "HybridFileSystem::create() : Filename already taken\n";
+            return;
+        }
+
+        // bounded-metadata mode : refuse growth once host metadata passes the cap.
+        if(metadata_budget && get_memory_footprint().total() > metadata_budget){
+            cerr << "HybridFileSystem::create() : metadata budget exceeded, cannot create " << filename << "\n";
+            return;
+        }
+        if(free_count < size){
+            cerr << "HybridFileSystem::create() : cannot allocate " << size << " blocks for " << filename << "\n";
+            return;
+        }
+
+        File* fp = alloc_file(size);
+
+        // the hybrid decision : one extent if any free run covers the file,
+        // an index carved from the largest runs once fragmentation denies
+        // it. empty files own no blocks at all.
+        if(size > 0){
+            int start = take_best(size);
+            if(start != -1){
+                append_extent(fp, start, size);
+            }
+            else{
+                fp->layout = INDEXED;
+                int remaining = size;
+                while(remaining > 0){
+                    int len;
+                    int rstart = carve_largest(remaining, len);
+                    append_extent(fp, rstart, len);
+                    remaining -= len;
+                }
+            }
+        }
+
+        used_memory += size;
+        fp->name = filename;
+        file_map.insert(filename, fp);
+        if constexpr (fs_stats_enabled)
+            if(file_map.bucket_count() != buckets)
+                stats.rehashes++;
+        if(fs_summary(verbosity) && !fp->extents.empty())
+            cout << "HybridFileSystem::create() : file " << filename
+                 << (fp->layout == EXTENT ? " created contiguous at block " : " created indexed at block ")
+                 << fp->extents[0].first << endl;
+    }
+
+    /**
+     * @brief creates a batch of files in one call.
+     *
+     * the hybrid decision is one ordered lookup per file, so the batch
+     * applies the creates in order.
+     *
+     * @param files name/size pairs to create.
+     * @return int - number of files actually created.
+     */
+    int create_batch(const vector<pair<string, int>>& files){
+        size_t before = file_map.size();
+        for(auto& f : files)
+            create(f.first, f.second);
+        return file_map.size() - before;
+    }
+
+    /**
+     * @brief deletes a batch of files in one call.
+     *
+     * @param filenames files to delete.
+     * @return int - number of files deleted.
+     */
+    int delete_batch(const vector<string>& filenames){
+        size_t before = file_map.size();
+        for(auto& name : filenames)
+            delete_file(name);
+        return before - file_map.size();
+    }
+
+    /**
+     * @brief resolves a filename to a small integer handle for the hot-path overloads.
+     *
+     * The handle stays valid until the file is deleted; opening the same file
+     * again returns the same handle.
+     *
+     * @param filename name of the file.
+     * @return int - file handle, -1 if the file does not exist.
+     */
+    int open_file(const string& filename){
+        File* fp = file_map.find(filename);
+        if(!fp)
+            return -1;
+        if(fp->handle == -1){
+            fp->handle = handles.size();
+            handles.push_back(fp);
+        }
+        return fp->handle;
+    }
+
+    /**
+     * @brief reads 'size' blocks of the file from given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to read.
+     * @param offset block number to start reading.
+     * @return int - number of block accesses taken to read the file.
+     */
+    int read(string filename, int size = -1, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "HybridFileSystem::read() : File " << filename << " not found\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    /**
+     * @brief reads by file handle, skipping the name lookup.
+     */
+    int read(int fd, int size = -1, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "HybridFileSystem::read() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return read_file(fp, size, offset);
+    }
+
+    private:
+
+    int read_file(File* fp, int size, int offset){
+        int block_access = 1;
+        size = (size == -1) ? fp->filesize : size;
+        int read = 0;
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
+        for(int i = offset; i < fp->filesize && read < size; i++){
+            int b = block_at(fp, i);
+            if(fs_trace(verbosity))
+                cout << "HybridFileSystem::read() : Reading block " << b << endl;
+            read++;
+            bool hit = cache && cache->access(b);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, b, hit);
+        }
+        last_io = io;
+        if(fs_summary(verbosity))
+            cout << "HybridFileSystem::read() : Total blocks read : " << read << endl;
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief writes 'size' blocks starting from the given offset.
+     *
+     * @param filename name of the file.
+     * @param size number of blocks to write.
+     * @param offset starting block to write from.
+     * @return int - number of block accesses taken to write the file.
+     */
+    int write(string filename, int size, int offset = 0){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "HybridFileSystem::write() : File " << filename << " not found\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    /**
+     * @brief writes by file handle, skipping the name lookup.
+     */
+    int write(int fd, int size, int offset = 0){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "HybridFileSystem::write() : bad file handle " << fd << "\n";
+            return 1;
+        }
+        return write_file(fp, size, offset);
+    }
+
+    private:
+
+    int write_file(File* fp, int size, int offset){
+        int block_access = 1;
+        int written = 0;
+        int bno = offset;
+
+        if(offset + size > fp->filesize && offset + size - fp->filesize > free_count){
+            cerr << "HybridFileSystem::write() : cannot allocate memory for write\n";
+            return block_access;
+        }
+
+        // grow past the end : stay contiguous when the blocks right after
+        // the extent are free, otherwise the file goes INDEXED. files that
+        // own no blocks yet get the same extent-first placement as create.
+        if(offset + size > fp->filesize){
+            int need = offset + size - fp->filesize;
+            if(fp->extents.empty()){
+                int start = take_best(need);
+                if(start != -1){
+                    append_extent(fp, start, need);
+                    fp->filesize += need;
+                    used_memory += need;
+                    need = 0;
+                }
+            }
+            auto it = need > 0 && !fp->extents.empty()
+                ? free_extents.find(fp->extents.back().first + fp->extents.back().second)
+                : free_extents.end();
+            if(it != free_extents.end()){
+                int tail = it->first;
+                int take = min(need, it->second);
+                int rlen = it->second;
+                free_by_size.erase(free_by_size.find({rlen, tail}));
+                free_extents.erase(it);
+                if(rlen > take){
+                    free_extents[tail + take] = rlen - take;
+                    free_by_size.insert({rlen - take, tail + take});
+                }
+                free_count -= take;
+                append_extent(fp, tail, take);
+                fp->filesize += take;
+                used_memory += take;
+                need -= take;
+            }
+            while(need > 0){
+                fp->layout = INDEXED;
+                int len;
+                int rstart = carve_largest(need, len);
+                append_extent(fp, rstart, len);
+                fp->filesize += len;
+                used_memory += len;
+                need -= len;
+            }
+        }
+
+        IoResult io;
+        io.cost = cost_model.seek_cost;  // the metadata access.
+        int prev = INT_MIN;
+        while(written < size){
+            int b = block_at(fp, bno);
+            if(fs_trace(verbosity))
+                cout << "HybridFileSystem::write() : Writing block " << b << endl;
+            bool hit = cache && cache->access(b);
+            if(!hit)
+                block_access++;
+            charge_touch(cost_model, io, prev, b, hit);
+            written++;
+            bno++;
+        }
+        last_io = io;
+        if(fs_summary(verbosity))
+            cout << "HybridFileSystem::write() : Total blocks written : " << written << endl;
+        return block_access;
+    }
+
+    public:
+
+    /**
+     * @brief removes the given file from the filesystem.
+     *
+     * @param filename name of the file.
+     */
+    void delete_file(string filename){
+        File* fp = file_map.find(filename);
+        if(!fp){
+            cerr << "HybridFileSystem::delete() : File not found.\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes by file handle, skipping the name lookup.
+     */
+    void delete_file(int fd){
+        File* fp = handle_file(fd);
+        if(!fp){
+            cerr << "HybridFileSystem::delete() : bad file handle " << fd << "\n";
+            return;
+        }
+        delete_fp(fp);
+    }
+
+    /**
+     * @brief deletes every file under the given directory in one pass.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return int - number of files deleted.
+     */
+    int delete_tree(string dirname){
+        int removed = file_map.erase_under(dirname, [&](File* fp){ drop_file(fp); });
+        if(fs_summary(verbosity))
+            cout << "HybridFileSystem::delete_tree() : " << removed << " files deleted under " << dirname << endl;
+        return removed;
+    }
+
+    /**
+     * @brief full names of every file under the given directory.
+     *
+     * @param dirname directory path, with or without a trailing '/'.
+     * @return vector<string> - the files' full paths.
+     */
+    vector<string> list_dir(string dirname){
+        vector<string> out;
+        file_map.for_each_under(dirname, [&](File* fp){ out.push_back(fp->name); });
+        return out;
+    }
+
+    private:
+
+    // namespace removal and resource teardown are separate so the
+    // subtree delete can unlink a whole directory once and reap per file.
+    void delete_fp(File* fp){
+        file_map.erase(fp->name);
+        drop_file(fp);
+    }
+
+    void drop_file(File* fp){
+        StatsTimer _t(stats.delete_ns);
+        if constexpr (fs_stats_enabled)
+            stats.deletes++;
+        if(fs_summary(verbosity))
+            cout << "HybridFileSystem::delete() : deallocating file blocks\n";
+        for(auto& e : fp->extents)
+            free_run(e.first, e.second);
+        if(fp->handle != -1)
+            handles[fp->handle] = nullptr;
+        used_memory -= fp->filesize;
+        if(fs_summary(verbosity))
+            cout << "HybridFileSystem::delete() : " << fp->name << " deleted\n";
+        release_file(fp);
+    }
+
+    public:
+
+    /**
+     * @brief Get the storage efficiency of the file system.
+     *
+     * @return float - returns the ratio of used memory to the total memory size.
+     */
+    float get_storage_efficiency(){
+        return (float)used_memory/N;
+    }
+
+    /**
+     * @brief estimated host-heap bytes behind this instance, by structure.
+     *
+     * no data plane or bitmap here, so the per-file extent vectors and the
+     * two free-run indexes are the whole bill.
+     */
+    MemoryFootprint get_memory_footprint(){
+        MemoryFootprint f;
+        f.file_records = deque_heap_bytes(slab) + vec_heap_bytes(slab_free);
+        for(const File& rec : slab)
+            f.file_records += vec_heap_bytes(rec.extents) + vec_heap_bytes(rec.ext_off)
+                            + string_heap_bytes(rec.name);
+        f.free_lists = map_heap_bytes(free_extents) + set_heap_bytes(free_by_size);
+        f.name_map = file_map.footprint() + vec_heap_bytes(handles);
+        if(f.total() > mem_high_water)
+            mem_high_water = f.total();
+        return f;
+    }
+
+    /**
+     * @brief bounded-metadata mode : creates fail once the footprint
+     * passes the budget. 0 (the default) lifts the cap.
+     */
+    void set_metadata_budget(size_t bytes){
+        metadata_budget = bytes;
+    }
+
+    /**
+     * @brief largest footprint total observed so far; refreshed here and
+     * by every budget check and get_memory_footprint() call.
+     */
+    size_t get_metadata_high_water(){
+        get_memory_footprint();
+        return mem_high_water;
+    }
+
+    /**
+     * @brief fragmentation picture of the free space, in O(1).
+     *
+     * read straight off the maintained free-run indexes; a rising
+     * external_frag is what pushes new files onto the indexed layout.
+     */
+    FragmentationStats get_fragmentation_stats(){
+        FragmentationStats fr;
+        fr.hole_count = free_extents.size();
+        fr.free_blocks = free_count;
+        if(!free_by_size.empty())
+            fr.largest_hole = std::prev(free_by_size.end())->first;
+        if(fr.hole_count > 0)
+            fr.mean_hole = (float)fr.free_blocks / fr.hole_count;
+        if(fr.free_blocks > 0)
+            fr.external_frag = 1.0f - (float)fr.largest_hole / fr.free_blocks;
+        return fr;
+    }
+
+    /**
+     * @brief how many live files sit on each layout.
+     *
+     * the crossover between the two is the number to watch on mixed
+     * workloads : it moves with fragmentation, not with file count.
+     *
+     * @return pair<int, int> - (contiguous files, indexed files).
+     */
+    pair<int, int> layout_mix(){
+        pair<int, int> mix = {0, 0};
+        file_map.for_each([&](File* fp){
+            (fp->layout == EXTENT ? mix.first : mix.second)++;
+        });
+        return mix;
+    }
+
+    void set_verbosity(Verbosity v){
+        verbosity = v;
+    }
+
+    /**
+     * @brief attaches (or detaches, with nullptr) a shared buffer cache.
+     */
+    void attach_cache(BufferCache* c){
+        cache = c;
+    }
+
+    /**
+     * @brief sets the cost weights applied to subsequent reads and writes.
+     */
+    void set_cost_model(CostModel m){
+        cost_model = m;
+    }
+
+    /**
+     * @brief cost-model accounting of the most recent read or write.
+     */
+    IoResult get_last_io(){
+        return last_io;
+    }
+
+    /**
+     * @brief returns a copy of the instrumentation counters.
+     */
+    FsStats get_stats(){
+        FsStats out = stats;
+        out.free_runs = free_extents.size();
+        return out;
+    }
+};
+
+/**
+ * @brief thread-safe wrapper around any of the filesystem classes.
+ *
+ * Concurrency is a policy : single-threaded users keep using the classes
+ * directly and pay no synchronization cost; concurrent clients wrap an
+ * instance in this adapter. Reads are not pure : they advance per-file
+ * state (the linked classes' sequential cursor) and the io-accounting
+ * scratch. So read() takes its file's lock stripe plus a shared structure
+ * lock - reads on the same stripe serialize, reads on distinct stripes
+ * proceed in parallel. Mutating operations take the same striped per-file
+ * mutex plus the structure lock exclusively while they touch the name map
+ * and allocator. Stripes are chosen by filename hash; a handle inherits
+ * its file's stripe at open, so name-based and handle-based access to one
+ * file always contend on the same stripe. attach_cache
+ * is deliberately not forwarded : a shared cache is mutated on every
+ * access, outside the stripe discipline.
+ *
+ * @tparam FS any of the filesystem classes.
+ * @tparam Shards number of lock stripes.
+ */
+template<typename FS, size_t Shards = 16>
+class ConcurrentFileSystem{
+
+    FS fs;
+    mutable shared_mutex struct_mtx;    // guards file_map, handles and the allocator.
+    array<mutex, Shards> file_mtx;      // lock stripes serializing same-file mutations.
+    mutable mutex fd_mtx;               // guards fd_stripe only; a leaf lock, never
+                                        // held while taking a stripe or struct_mtx.
+    vector<size_t> fd_stripe;           // handle -> its file's stripe, recorded at open.
+
+    size_t shard_of(const string& filename){
+        return hash<string>{}(filename) % Shards;
+    }
+    size_t shard_of(int fd){
+        // a handle must land on the same stripe as the name it was opened
+        // under, or mixed name/handle access to one file would hold two
+        // different stripes and race on the per-file cursor.
+        lock_guard<mutex> l(fd_mtx);
+        if(fd >= 0 && (size_t)fd < fd_stripe.size())
+            return fd_stripe[fd];
+        return (size_t)fd % Shards;  // bad handle : the wrapped call fails anyway.
+    }
+
+    public:
+
+    ConcurrentFileSystem() {}
+
+    template<typename... Args>
+    ConcurrentFileSystem(Args... args) : fs(args...) {}
+
+    void create(string filename, int filesize){
+        lock_guard<mutex> f(file_mtx[shard_of(filename)]);
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.create(filename, filesize);
+    }
+
+    int create_batch(const vector<pair<string, int>>& files){
+        // spans many stripes; the exclusive structure lock covers the burst.
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.create_batch(files);
+    }
+
+    int delete_batch(const vector<string>& filenames){
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.delete_batch(filenames);
+    }
+
+    int open_file(const string& filename){
+        // allocates a handle slot, so this needs the structure lock exclusively.
+        unique_lock<shared_mutex> s(struct_mtx);
+        int fd = fs.open_file(filename);
+        if(fd >= 0){
+            lock_guard<mutex> l(fd_mtx);
+            if((size_t)fd >= fd_stripe.size())
+                fd_stripe.resize(fd + 1);
+            fd_stripe[fd] = shard_of(filename);
+        }
+        return fd;
+    }
+
+    int read(string filename, int size = -1, int offset = 0){
+        // reads advance per-file cursor state, so they hold their stripe.
+        lock_guard<mutex> f(file_mtx[shard_of(filename)]);
+        shared_lock<shared_mutex> s(struct_mtx);
+        return fs.read(filename, size, offset);
+    }
+
+    int read(int fd, int size = -1, int offset = 0){
+        lock_guard<mutex> f(file_mtx[shard_of(fd)]);
+        shared_lock<shared_mutex> s(struct_mtx);
+        return fs.read(fd, size, offset);
+    }
+
+    int write(string filename, int size, int offset = 0){
+        lock_guard<mutex> f(file_mtx[shard_of(filename)]);
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.write(filename, size, offset);
+    }
 
-        cout << "ModifiedContigousFileSystem::delete() : deallocating block\n";
-        File* fp = file_map[filename];
-        block* b = fp->start;
+    int write(int fd, int size, int offset = 0){
+        lock_guard<mutex> f(file_mtx[shard_of(fd)]);
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.write(fd, size, offset);
+    }
 
-        //iterate through each chunk, marking each block in the chunk as free.
-        while(b){
-            for(int i = 0; i < b->size; i++){
-                this->memory_map.reset(b->start_block+i);
+    void delete_file(string filename){
+        lock_guard<mutex> f(file_mtx[shard_of(filename)]);
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.delete_file(filename);
+    }
+
+    void delete_file(int fd){
+        lock_guard<mutex> f(file_mtx[shard_of(fd)]);
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.delete_file(fd);
+    }
+
+    int delete_tree(string dirname){
+        // touches files across every stripe, so the exclusive structure
+        // lock alone serializes it against all other operations.
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.delete_tree(dirname);
+    }
+
+    void clone_file(string srcname, string dstname){
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.clone_file(srcname, dstname);
+    }
+
+    int snapshot(const string& tag){
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.snapshot(tag);
+    }
+
+    vector<string> list_dir(string dirname){
+        shared_lock<shared_mutex> s(struct_mtx);
+        return fs.list_dir(dirname);
+    }
+
+    float get_storage_efficiency(){
+        shared_lock<shared_mutex> s(struct_mtx);
+        return fs.get_storage_efficiency();
+    }
+
+    MemoryFootprint get_memory_footprint(){
+        // refreshes the wrapped high-water mark, so exclusive.
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.get_memory_footprint();
+    }
+
+    void set_metadata_budget(size_t bytes){
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.set_metadata_budget(bytes);
+    }
+
+    size_t get_metadata_high_water(){
+        unique_lock<shared_mutex> s(struct_mtx);
+        return fs.get_metadata_high_water();
+    }
+
+    void set_verbosity(Verbosity v){
+        unique_lock<shared_mutex> s(struct_mtx);
+        fs.set_verbosity(v);
+    }
+};
+
+/**
+ * @brief two-stage operation pipeline overlapping lookups with block work.
+ *
+ * Stage one resolves each operation's name to a handle (the hash lookup);
+ * stage two runs the block traversal or copy. Each stage has its own thread,
+ * so the lookup of operation N+1 proceeds while operation N is still
+ * touching blocks. Mutating operations (create/delete) act as barriers :
+ * stage one holds them until stage two drains, which keeps results identical
+ * to a serial run. The wrapped filesystem must be individually thread-safe -
+ * wrap a plain instance in ConcurrentFileSystem first.
+ *
+ * @tparam FS a thread-safe filesystem, typically ConcurrentFileSystem<...>.
+ */
+template<typename FS>
+class AsyncPipeline{
+
+    enum Kind : uint8_t { READ, WRITE, CREATE, DELETE, DELTREE };
+
+    struct Job{
+        Kind kind = READ;
+        string name;
+        int a = 0, b = 0;
+        int fd = -1;
+        promise<int> done;
+    };
+
+    FS& fs;
+    deque<Job> in_q, mid_q;
+    mutex in_mtx, mid_mtx;
+    condition_variable in_cv, mid_cv, idle_cv;
+    // read from wait predicates under either queue's mutex, so atomic.
+    atomic<bool> stop{false};
+    bool meta_done = false;
+    bool block_busy = false;
+    thread meta_thread, block_thread;
+
+    /**
+     * @brief stage one : name resolution, and barriers for mutations.
+     */
+    void meta_loop(){
+        while(true){
+            Job job;
+            {
+                unique_lock<mutex> l(in_mtx);
+                in_cv.wait(l, [&]{ return stop || !in_q.empty(); });
+                if(in_q.empty())
+                    break;
+                job = move(in_q.front());
+                in_q.pop_front();
+            }
+            if(job.kind == READ || job.kind == WRITE){
+                job.fd = fs.open_file(job.name);  // the hash lookup.
+                {
+                    lock_guard<mutex> l(mid_mtx);
+                    mid_q.push_back(move(job));
+                }
+                mid_cv.notify_one();
+            }
+            else{
+                // mutations wait for the block stage so that every earlier
+                // operation sees the namespace it was submitted against.
+                wait_block_idle();
+                if(job.kind == CREATE){
+                    fs.create(job.name, job.a);
+                    job.done.set_value(0);
+                }
+                else if(job.kind == DELETE){
+                    fs.delete_file(job.name);
+                    job.done.set_value(0);
+                }
+                else
+                    job.done.set_value(fs.delete_tree(job.name));
             }
-            block* next = b->next;
-            delete b;
-            b = next;
         }
-        
-        this->used_memory -= fp->filesize;
-        file_map.erase(filename);
-        delete fp;
+        {
+            lock_guard<mutex> l(mid_mtx);
+            meta_done = true;
+        }
+        mid_cv.notify_all();
+    }
+
+    /**
+     * @brief stage two : the block traversal or copy per operation.
+     */
+    void block_loop(){
+        while(true){
+            Job job;
+            {
+                unique_lock<mutex> l(mid_mtx);
+                mid_cv.wait(l, [&]{ return !mid_q.empty() || (stop && meta_done); });
+                if(mid_q.empty())
+                    return;
+                job = move(mid_q.front());
+                mid_q.pop_front();
+                block_busy = true;
+            }
+            int ba = (job.kind == READ) ? fs.read(job.fd, job.a, job.b)
+                                        : fs.write(job.fd, job.a, job.b);
+            job.done.set_value(ba);
+            {
+                lock_guard<mutex> l(mid_mtx);
+                block_busy = false;
+            }
+            idle_cv.notify_all();
+        }
+    }
+
+    void wait_block_idle(){
+        unique_lock<mutex> l(mid_mtx);
+        idle_cv.wait(l, [&]{ return mid_q.empty() && !block_busy; });
+    }
+
+    future<int> enqueue(Kind kind, const string& name, int a, int b){
+        Job job;
+        job.kind = kind;
+        job.name = name;
+        job.a = a;
+        job.b = b;
+        future<int> f = job.done.get_future();
+        {
+            lock_guard<mutex> l(in_mtx);
+            in_q.push_back(move(job));
+        }
+        in_cv.notify_one();
+        return f;
+    }
+
+    public:
 
-        cout << "ModifiedContigousFileSystem::delete() : " << filename << " deleted\n";
+    explicit AsyncPipeline(FS& fs) : fs(fs){
+        meta_thread = thread([this]{ meta_loop(); });
+        block_thread = thread([this]{ block_loop(); });
+    }
+
+    // queued work is finished before the threads go; callers that care about
+    // results hold the futures anyway.
+    ~AsyncPipeline(){
+        {
+            lock_guard<mutex> l(in_mtx);
+            stop = true;
+        }
+        in_cv.notify_all();
+        mid_cv.notify_all();
+        meta_thread.join();
+        block_thread.join();
+    }
+
+    AsyncPipeline(const AsyncPipeline&) = delete;
+
+    /**
+     * @brief queues a read; the future yields its block-access count.
+     */
+    future<int> async_read(const string& name, int size = -1, int offset = 0){
+        return enqueue(READ, name, size, offset);
+    }
+
+    /**
+     * @brief queues a write; the future yields its block-access count.
+     */
+    future<int> async_write(const string& name, int size, int offset = 0){
+        return enqueue(WRITE, name, size, offset);
+    }
+
+    /**
+     * @brief queues a create; a barrier for everything in flight.
+     */
+    future<int> async_create(const string& name, int size){
+        return enqueue(CREATE, name, size, 0);
+    }
+
+    /**
+     * @brief queues a delete; a barrier for everything in flight.
+     */
+    future<int> async_delete(const string& name){
+        return enqueue(DELETE, name, 0, 0);
+    }
+
+    /**
+     * @brief queues a subtree delete; the future yields the files removed.
+     */
+    future<int> async_delete_tree(const string& dir){
+        return enqueue(DELTREE, dir, 0, 0);
     }
 };
 
-int main(int argc, char* argv[]){
-    if(argc < 2){
-        cerr << "Provide input query file\n";
-        exit(EXIT_FAILURE);
+/**
+ * @brief returns the given percentile of an already-sorted latency sample.
+ *
+ * @param sorted per-operation latencies in nanoseconds, ascending.
+ * @param p percentile in [0, 100].
+ * @return long long - latency at that percentile.
+ */
+long long bench_percentile(const vector<long long>& sorted, double p){
+    if(sorted.empty())
+        return 0;
+    size_t i = (size_t)(p/100.0 * (sorted.size()-1) + 0.5);
+    return sorted[i];
+}
+
+/**
+ * @brief emits one CSV row for a finished workload.
+ */
+void bench_report(const string& fs, const string& strategy, const string& workload, vector<long long>& lat){
+    sort(lat.begin(), lat.end());
+    long long wall = 0;
+    for(long long v : lat)
+        wall += v;
+    double wall_ms = wall / 1e6;
+    double ops_sec = lat.empty() ? 0 : lat.size() / (wall / 1e9);
+    cout << fs << "," << strategy << "," << workload << "," << lat.size() << ","
+         << wall_ms << "," << (long long)ops_sec << ","
+         << bench_percentile(lat, 50) << "," << bench_percentile(lat, 95) << ","
+         << bench_percentile(lat, 99) << "\n";
+}
+
+/**
+ * @brief runs the parameterized workloads against one filesystem instance.
+ *
+ * Workloads : create/delete churn, sequential whole-file reads, random reads
+ * and append-heavy writes. Each operation is timed individually and reported
+ * as a CSV row per workload.
+ *
+ * @tparam FS any of the filesystem classes.
+ * @param fs the instance, already set QUIET.
+ * @param fs_name name for the CSV.
+ * @param strategy strategy label for the CSV ("-" where not applicable).
+ */
+template<typename FS>
+void bench_one(FS& fs, const string& fs_name, const string& strategy){
+    using clock = chrono::steady_clock;
+    mt19937 rng(42);
+    const int files = 64, rounds = 16;
+
+    auto timed = [](vector<long long>& lat, auto&& op){
+        auto t0 = clock::now();
+        op();
+        auto t1 = clock::now();
+        lat.push_back(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+    };
+
+    // create/delete churn.
+    vector<long long> lat_churn;
+    for(int r = 0; r < rounds; r++){
+        for(int i = 0; i < files; i++){
+            int sz = 1 + (int)(rng() % 16);
+            timed(lat_churn, [&]{ fs.create("bench_" + to_string(i), sz); });
+        }
+        for(int i = 0; i < files; i++)
+            timed(lat_churn, [&]{ fs.delete_file("bench_" + to_string(i)); });
+    }
+    bench_report(fs_name, strategy, "churn", lat_churn);
+
+    // working set for the read/write workloads, accessed by handle.
+    vector<int> fds(files), sizes(files);
+    for(int i = 0; i < files; i++){
+        sizes[i] = 4 + (int)(rng() % 12);
+        fs.create("bench_" + to_string(i), sizes[i]);
+        fds[i] = fs.open_file("bench_" + to_string(i));
     }
 
-    ModifiedContiguousFileSystem<500> mcfs;
-    LinkedFileSystem<500> lfs;
-    IndexedFileSystem<500> ifs;
-    ContiguousFileSystem<500> cfs(ContiguousFileSystem<500>::BEST_FIT);
-
-    ifstream infile(argv[1]);
-    string line;
-
-    int cfs_time = 0, lfs_time = 0, mcfs_time = 0, ifs_time = 0;
-    int success_cfs = 0, success_lfs = 0, success_mcfs = 0, success_ifs = 0;
-
-    while (getline(infile, line)) {
-        stringstream ss(line);
-        string operation, file_name;
-        int file_size, size, offset;
-
-        ss >> operation >> file_name;
-
-        if (operation == "CREATE") {
-            ss >> file_size;
-            mcfs.create(file_name, file_size);
-            cfs.create(file_name, file_size);
-            ifs.create(file_name, file_size);
-            lfs.create(file_name, file_size);
-        } 
-        else if (operation == "READ") {
-            ss >> size >> offset;
-            int ba = 0;
-            ba = mcfs.read(file_name, size, offset);
-            if(ba != 1){
-                success_mcfs++;
-                mcfs_time += ba;
+    // sequential whole-file reads.
+    vector<long long> lat_seq;
+    for(int r = 0; r < 32; r++)
+        for(int i = 0; i < files; i++)
+            timed(lat_seq, [&]{ fs.read(fds[i], sizes[i], 0); });
+    bench_report(fs_name, strategy, "seq_read", lat_seq);
+
+    // random partial reads.
+    vector<long long> lat_rand;
+    for(int r = 0; r < 1024; r++){
+        int i = rng() % files;
+        int off = rng() % sizes[i];
+        timed(lat_rand, [&]{ fs.read(fds[i], 1 + (int)(rng() % 4), off); });
+    }
+    bench_report(fs_name, strategy, "rand_read", lat_rand);
+
+    // append-heavy writes : every write lands one block past the current end.
+    vector<long long> lat_app;
+    for(int r = 0; r < 8; r++)
+        for(int i = 0; i < files; i++){
+            timed(lat_app, [&]{ fs.write(fds[i], 1, sizes[i]); });
+            sizes[i]++;
+        }
+    bench_report(fs_name, strategy, "append", lat_app);
+
+    for(int i = 0; i < files; i++)
+        fs.delete_file(fds[i]);
+}
+
+/**
+ * @brief benchmark entry point : all filesystem classes, all strategies, CSV to stdout.
+ */
+void run_bench(){
+    const size_t BN = 4096;
+    cout << "fs,strategy,workload,ops,wall_ms,ops_per_sec,p50_ns,p95_ns,p99_ns\n";
+
+    typedef ContiguousFileSystem<BN> CFS;
+    const pair<typename CFS::Strategy, const char*> strategies[] = {
+        {CFS::FIRST_FIT, "first_fit"}, {CFS::BEST_FIT, "best_fit"},
+        {CFS::NEXT_FIT, "next_fit"}, {CFS::WORST_FIT, "worst_fit"},
+        {CFS::BUDDY, "buddy"},
+    };
+
+    for(auto& s : strategies){
+        CFS cfs(s.first);
+        cfs.set_verbosity(QUIET);
+        bench_one(cfs, "contiguous", s.second);
+
+        // the modified layout frees chunks at exact sizes; buddy does not apply.
+        if(s.first == CFS::BUDDY)
+            continue;
+
+        ModifiedContiguousFileSystem<BN> mcfs(s.first);
+        mcfs.set_verbosity(QUIET);
+        bench_one(mcfs, "modified_contiguous", s.second);
+    }
+
+    LinkedFileSystem<BN> lfs;
+    lfs.set_verbosity(QUIET);
+    bench_one(lfs, "linked", "-");
+
+    LinkedFileSystem<BN, FAT> flfs;
+    flfs.set_verbosity(QUIET);
+    bench_one(flfs, "linked_fat", "-");
+
+    IndexedFileSystem<BN> ifs;
+    ifs.set_verbosity(QUIET);
+    bench_one(ifs, "indexed", "-");
+}
+
+/**
+ * @brief one decoded trace operation, with the filename replaced by an interned id.
+ */
+struct TraceOp{
+    enum Op : uint8_t { OP_CREATE, OP_READ, OP_WRITE, OP_DELETE, OP_DELTREE, OP_INVALID };
+    uint8_t op;
+    uint8_t pad[3];
+    int32_t name;  // index into the interned name table.
+    int32_t a;     // CREATE : filesize, READ/WRITE : size.
+    int32_t b;     // READ/WRITE : offset.
+};
+
+// magic tag at the start of pre-compiled binary traces.
+const char TRACE_MAGIC[8] = {'F','S','T','R','A','C','E','1'};
+
+/**
+ * @brief parses an integer in [p, e) after skipping blanks.
+ *
+ * @return const char* - position after the parsed number.
+ */
+const char* parse_int(const char* p, const char* e, int32_t& out){
+    while(p < e && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    bool neg = false;
+    if(p < e && *p == '-'){
+        neg = true;
+        p++;
+    }
+    int32_t v = 0;
+    while(p < e && *p >= '0' && *p <= '9'){
+        v = v*10 + (*p - '0');
+        p++;
+    }
+    out = neg ? -v : v;
+    return p;
+}
+
+/**
+ * @brief parses a whitespace-delimited token in [p, e) without copying it.
+ *
+ * @return const char* - position after the token.
+ */
+const char* parse_token(const char* p, const char* e, string_view& tok){
+    while(p < e && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    const char* s = p;
+    while(p < e && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+        p++;
+    tok = string_view(s, p - s);
+    return p;
+}
+
+/**
+ * @brief parses a text query trace in place from a memory-mapped buffer.
+ *
+ * Filenames are interned : each distinct name gets an id and ops refer to it,
+ * so no strings are allocated per operation.
+ *
+ * @param p start of the buffer.
+ * @param e end of the buffer.
+ * @param ops decoded operations, appended in trace order.
+ * @param names interned filename table.
+ */
+void parse_text_trace(const char* p, const char* e, vector<TraceOp>& ops, vector<string>& names){
+    unordered_map<string_view, int32_t> name_ids;
+
+    while(p < e){
+        const char* line_end = (const char*)memchr(p, '\n', e - p);
+        if(!line_end)
+            line_end = e;
+
+        string_view opname, fname;
+        const char* q = parse_token(p, line_end, opname);
+        p = line_end + 1;
+
+        if(opname.empty())
+            continue;
+
+        TraceOp t = {};
+        if(opname == "CREATE")
+            t.op = TraceOp::OP_CREATE;
+        else if(opname == "READ")
+            t.op = TraceOp::OP_READ;
+        else if(opname == "WRITE")
+            t.op = TraceOp::OP_WRITE;
+        else if(opname == "DELETE_FILE")
+            t.op = TraceOp::OP_DELETE;
+        else if(opname == "DELTREE")
+            t.op = TraceOp::OP_DELTREE;
+        else{
+            cout << "Invalid operation: " << opname << "\n";
+            continue;
+        }
+
+        q = parse_token(q, line_end, fname);
+        auto it = name_ids.find(fname);
+        if(it == name_ids.end()){
+            it = name_ids.insert({fname, (int32_t)names.size()}).first;
+            names.push_back(string(fname));
+        }
+        t.name = it->second;
+
+        q = parse_int(q, line_end, t.a);
+        if(t.op == TraceOp::OP_READ || t.op == TraceOp::OP_WRITE)
+            q = parse_int(q, line_end, t.b);
+
+        ops.push_back(t);
+    }
+}
+
+/**
+ * @brief loads a query trace, either text or pre-compiled binary.
+ *
+ * The file is memory-mapped and parsed in place; binary traces are detected
+ * by their magic header and replay with no parsing at all.
+ *
+ * @param path trace file.
+ * @param ops decoded operations.
+ * @param names interned filename table.
+ * @return true on success.
+ */
+bool load_trace(const char* path, vector<TraceOp>& ops, vector<string>& names){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        cerr << "load_trace() : cannot open " << path << "\n";
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        close(fd);
+        cerr << "load_trace() : cannot read " << path << "\n";
+        return false;
+    }
+
+    size_t len = st.st_size;
+    const char* base = (const char*)mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED){
+        cerr << "load_trace() : mmap failed for " << path << "\n";
+        return false;
+    }
+
+    const char* p = base;
+    const char* e = base + len;
+
+    if(len >= sizeof(TRACE_MAGIC) && memcmp(p, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0){
+        // binary trace : magic, name count, op count, length-prefixed names,
+        // packed ops. every field is validated against the mapping end the
+        // way the snapshot loader does - a truncated or corrupt trace must
+        // fail cleanly, not parse garbage or allocate whatever a forged
+        // header asks for.
+        p += sizeof(TRACE_MAGIC);
+        uint32_t nnames = 0, nops = 0;
+        bool ok = snap_get(p, e, nnames) && snap_get(p, e, nops)
+               && (size_t)nops <= (size_t)(e - p) / sizeof(TraceOp);
+
+        names.reserve(ok ? nnames : 0);
+        for(uint32_t i = 0; ok && i < nnames; i++){
+            string name;
+            ok = snap_get_str(p, e, name);
+            if(ok)
+                names.push_back(move(name));
+        }
+
+        ok = ok && (size_t)(e - p) >= (size_t)nops * sizeof(TraceOp);
+        if(ok){
+            ops.resize(nops);
+            memcpy(ops.data(), p, (size_t)nops * sizeof(TraceOp));
+        }
+
+        // replay indexes names[t.name] unchecked, so reject any op whose
+        // name id points outside the table.
+        for(size_t i = 0; ok && i < ops.size(); i++)
+            ok = ops[i].name >= 0 && (uint32_t)ops[i].name < nnames;
+
+        if(!ok){
+            cerr << "load_trace() : malformed binary trace " << path << "\n";
+            ops.clear();
+            names.clear();
+            munmap((void*)base, len);
+            return false;
+        }
+    }
+    else{
+        parse_text_trace(p, e, ops, names);
+    }
+
+    munmap((void*)base, len);
+    return true;
+}
+
+/**
+ * @brief compiles a decoded trace into the packed binary format.
+ *
+ * @param path output file.
+ * @param ops decoded operations.
+ * @param names interned filename table.
+ * @return true on success.
+ */
+bool write_binary_trace(const char* path, const vector<TraceOp>& ops, const vector<string>& names){
+    ofstream out(path, ios::binary);
+    if(!out){
+        cerr << "write_binary_trace() : cannot open " << path << "\n";
+        return false;
+    }
+
+    out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    uint32_t nnames = names.size(), nops = ops.size();
+    out.write((const char*)&nnames, 4);
+    out.write((const char*)&nops, 4);
+    for(const string& s : names){
+        uint32_t l = s.size();
+        out.write((const char*)&l, 4);
+        out.write(s.data(), l);
+    }
+    out.write((const char*)ops.data(), (size_t)nops * sizeof(TraceOp));
+    return out.good();
+}
+
+/**
+ * @brief configuration of the synthetic workload generator.
+ */
+struct WorkloadConfig{
+    enum SizeDist { UNIFORM, ZIPF, LOGNORMAL };
+    uint64_t seed = 1;
+    int nops = 10000;         // operations to generate.
+    int max_files = 100;      // cap on simultaneously live files.
+    SizeDist size_dist = UNIFORM;
+    int min_size = 1;         // file size bounds, in blocks.
+    int max_size = 64;
+    double zipf_s = 1.2;      // zipf exponent over [min_size, max_size].
+    double lognorm_mu = 2.0;  // lognormal parameters of the block count.
+    double lognorm_sigma = 0.7;
+    double read_frac = 0.4;   // probability of a READ per op.
+    double write_frac = 0.2;  // probability of a WRITE per op.
+    double churn = 0.1;       // probability of deleting a live file per op :
+                              // higher churn turns the working set over faster.
+};
+
+/**
+ * @brief deterministic synthetic workload generator.
+ *
+ * Produces CREATE/READ/WRITE/DELETE_FILE streams with a configurable file
+ * size distribution, read/write mix and working-set churn. The same seed
+ * always yields the same trace, so fragmentation studies are reproducible
+ * without hand-written input files.
+ */
+class WorkloadGenerator{
+    public:
+
+    WorkloadGenerator(const WorkloadConfig& cfg) : cfg(cfg), rng(cfg.seed){
+        // zipf sizes come from one inverse-CDF lookup per sample.
+        if(cfg.size_dist == WorkloadConfig::ZIPF){
+            zipf_cdf.resize(cfg.max_size - cfg.min_size + 1);
+            double c = 0;
+            for(int k = cfg.min_size; k <= cfg.max_size; k++){
+                c += 1.0 / pow((double)k, cfg.zipf_s);
+                zipf_cdf[k - cfg.min_size] = c;
             }
-            ba = cfs.read(file_name, size, offset);
-            if(ba != 1){
-                success_cfs++;
-                cfs_time += ba;
+            for(double& v : zipf_cdf)
+                v /= c;
+        }
+    }
+
+    /**
+     * @brief emits the workload as a decoded trace, ready for the replay engine.
+     *
+     * @param ops generated operations, appended in order.
+     * @param names interned filename table, appended to.
+     */
+    void generate(vector<TraceOp>& ops, vector<string>& names){
+        // the live set drives which names reads, writes and deletes may target.
+        vector<pair<int32_t, int>> live;  // (name id, filesize)
+        uniform_real_distribution<double> uni(0.0, 1.0);
+
+        while((int)ops.size() < cfg.nops){
+            double r = uni(rng);
+            TraceOp t = {};
+
+            bool create = live.empty() ||
+                (r >= cfg.churn + cfg.read_frac + cfg.write_frac && (int)live.size() < cfg.max_files);
+            if(create){
+                int size = sample_size();
+                t.op = TraceOp::OP_CREATE;
+                t.name = (int32_t)names.size();
+                t.a = size;
+                names.push_back("f" + to_string(names.size()));
+                live.push_back({t.name, size});
             }
-            ba = ifs.read(file_name, size, offset);
-            if(ba != 1){
-                success_ifs++;
-                ifs_time += ba;
+            else if(r < cfg.churn){
+                size_t i = rng() % live.size();
+                t.op = TraceOp::OP_DELETE;
+                t.name = live[i].first;
+                live[i] = live.back();
+                live.pop_back();
             }
-            ba = lfs.read(file_name, size, offset);
-            if(ba != 1){
-                success_lfs++;
-                lfs_time += ba;
+            else{
+                // read or write of a random in-bounds range of a live file.
+                auto& f = live[rng() % live.size()];
+                t.op = (r < cfg.churn + cfg.read_frac) ? TraceOp::OP_READ : TraceOp::OP_WRITE;
+                t.name = f.first;
+                t.a = 1 + (int)(rng() % f.second);
+                t.b = (int)(rng() % (f.second - t.a + 1));
             }
-        } 
-        else if (operation == "WRITE") {
-            ss >> size >> offset;
-            int ba;
-            ba = mcfs.write(file_name, size, offset);
-            if(ba != 1){
-                success_mcfs++;
-                mcfs_time += ba;
+            ops.push_back(t);
+        }
+    }
+
+    private:
+
+    /**
+     * @brief draws one file size from the configured distribution.
+     */
+    int sample_size(){
+        switch(cfg.size_dist){
+            case WorkloadConfig::ZIPF:{
+                double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+                int k = lower_bound(zipf_cdf.begin(), zipf_cdf.end(), u) - zipf_cdf.begin();
+                return cfg.min_size + k;
             }
-            ba = cfs.write(file_name, size, offset);
-            if(ba != 1){
-                success_cfs++;
-                cfs_time += ba;
+            case WorkloadConfig::LOGNORMAL:{
+                double v = lognormal_distribution<double>(cfg.lognorm_mu, cfg.lognorm_sigma)(rng);
+                return max(cfg.min_size, min(cfg.max_size, (int)llround(v)));
             }
-            ba = ifs.write(file_name, size, offset);
+            default:
+                return cfg.min_size + (int)(rng() % (cfg.max_size - cfg.min_size + 1));
+        }
+    }
+
+    WorkloadConfig cfg;
+    mt19937_64 rng;
+    vector<double> zipf_cdf;
+};
+
+/**
+ * @brief writes a decoded trace back out in the text query format.
+ *
+ * @param path output file.
+ * @param ops decoded operations.
+ * @param names interned filename table.
+ * @return true on success.
+ */
+bool write_text_trace(const char* path, const vector<TraceOp>& ops, const vector<string>& names){
+    ofstream out(path);
+    if(!out){
+        cerr << "write_text_trace() : cannot open " << path << "\n";
+        return false;
+    }
+    for(const TraceOp& t : ops){
+        if(t.op == TraceOp::OP_CREATE)
+            out << "CREATE " << names[t.name] << " " << t.a << "\n";
+        else if(t.op == TraceOp::OP_READ)
+            out << "READ " << names[t.name] << " " << t.a << " " << t.b << "\n";
+        else if(t.op == TraceOp::OP_WRITE)
+            out << "WRITE " << names[t.name] << " " << t.a << " " << t.b << "\n";
+        else if(t.op == TraceOp::OP_DELETE)
+            out << "DELETE_FILE " << names[t.name] << "\n";
+        else if(t.op == TraceOp::OP_DELTREE)
+            out << "DELTREE " << names[t.name] << "\n";
+    }
+    return out.good();
+}
+
+/**
+ * @brief accumulated results of one filesystem's pass over a trace.
+ */
+struct ReplayResult{
+    int time = 0;     // summed block accesses of successful read/write ops.
+    int success = 0;  // number of successful read/write ops.
+};
+
+/**
+ * @brief replays the decoded trace against one filesystem instance.
+ *
+ * The instances share no state, so each filesystem runs its own pass over
+ * the (read-only) decoded trace; the counters live in the per-pass result
+ * and are merged by the caller. Names are resolved to handles once at
+ * CREATE as before.
+ *
+ * @tparam FS any of the filesystem classes.
+ * @param fs the instance.
+ * @param ops decoded trace.
+ * @param names interned filename table.
+ * @return ReplayResult - accumulated counters for this filesystem.
+ */
+template<typename FS>
+ReplayResult replay_trace(FS& fs, const vector<TraceOp>& ops, const vector<string>& names){
+    ReplayResult res;
+    vector<int> handle(names.size(), -1);
+
+    for(const TraceOp& t : ops){
+        if(t.op == TraceOp::OP_CREATE){
+            fs.create(names[t.name], t.a);
+            handle[t.name] = fs.open_file(names[t.name]);
+        }
+        else if(t.op == TraceOp::OP_READ){
+            int ba = fs.read(handle[t.name], t.a, t.b);
             if(ba != 1){
-                success_ifs++;
-                ifs_time += ba;
+                res.success++;
+                res.time += ba;
             }
-            ba = lfs.write(file_name, size, offset);
+        }
+        else if(t.op == TraceOp::OP_WRITE){
+            int ba = fs.write(handle[t.name], t.a, t.b);
             if(ba != 1){
-                success_lfs++;
-                lfs_time += ba;
+                res.success++;
+                res.time += ba;
+            }
+        }
+        else if(t.op == TraceOp::OP_DELETE){
+            fs.delete_file(handle[t.name]);
+            handle[t.name] = -1;
+        }
+        else if(t.op == TraceOp::OP_DELTREE){
+            fs.delete_tree(names[t.name]);
+            // handles of the files under the prefix are now stale.
+            string prefix = names[t.name];
+            if(prefix.empty() || prefix.back() != '/')
+                prefix += '/';
+            for(size_t i = 0; i < names.size(); i++)
+                if(names[i].compare(0, prefix.size(), prefix) == 0)
+                    handle[i] = -1;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief replays the trace through the async pipeline, many ops in flight.
+ *
+ * Submission resolves nothing itself : the pipeline's lookup stage works on
+ * later operations while its block stage is still serving earlier ones.
+ * Results are drained in submission order a window behind the head, which
+ * keeps the queues full without holding every future of a long trace.
+ *
+ * @tparam FS a thread-safe filesystem, typically ConcurrentFileSystem<...>.
+ * @param fs the instance.
+ * @param ops decoded trace.
+ * @param names interned filename table.
+ * @return ReplayResult - accumulated counters, identical to a serial replay.
+ */
+template<typename FS>
+ReplayResult replay_trace_async(FS& fs, const vector<TraceOp>& ops, const vector<string>& names){
+    ReplayResult res;
+    AsyncPipeline<FS> pipe(fs);
+    deque<pair<uint8_t, future<int>>> inflight;
+
+    auto drain_one = [&]{
+        auto& f = inflight.front();
+        int ba = f.second.get();
+        if((f.first == TraceOp::OP_READ || f.first == TraceOp::OP_WRITE) && ba != 1){
+            res.success++;
+            res.time += ba;
+        }
+        inflight.pop_front();
+    };
+
+    for(const TraceOp& t : ops){
+        if(t.op == TraceOp::OP_CREATE)
+            inflight.push_back({t.op, pipe.async_create(names[t.name], t.a)});
+        else if(t.op == TraceOp::OP_READ)
+            inflight.push_back({t.op, pipe.async_read(names[t.name], t.a, t.b)});
+        else if(t.op == TraceOp::OP_WRITE)
+            inflight.push_back({t.op, pipe.async_write(names[t.name], t.a, t.b)});
+        else if(t.op == TraceOp::OP_DELETE)
+            inflight.push_back({t.op, pipe.async_delete(names[t.name])});
+        else if(t.op == TraceOp::OP_DELTREE)
+            inflight.push_back({t.op, pipe.async_delete_tree(names[t.name])});
+        while(inflight.size() > 1024)
+            drain_one();
+    }
+    while(!inflight.empty())
+        drain_one();
+    return res;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        cerr << "Provide input query file, or --bench\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // ./fs --bench : run the benchmark workloads and emit CSV.
+    if(string(argv[1]) == "--bench"){
+        run_bench();
+        return 0;
+    }
+
+    vector<TraceOp> ops;
+    vector<string> names;
+
+    // ./fs --gen [key=value ...] : generate a synthetic workload. with
+    // out=FILE the trace is written in the text format and the run ends;
+    // otherwise the generated ops feed the replay engine directly.
+    if(string(argv[1]) == "--gen"){
+        WorkloadConfig cfg;
+        string out;
+        for(int i = 2; i < argc; i++){
+            string arg = argv[i];
+            size_t eq = arg.find('=');
+            string key = arg.substr(0, eq);
+            string val = (eq == string::npos) ? "" : arg.substr(eq + 1);
+            if(key == "out") out = val;
+            else if(key == "seed") cfg.seed = stoull(val);
+            else if(key == "ops") cfg.nops = stoi(val);
+            else if(key == "files") cfg.max_files = stoi(val);
+            else if(key == "min") cfg.min_size = stoi(val);
+            else if(key == "max") cfg.max_size = stoi(val);
+            else if(key == "read") cfg.read_frac = stod(val);
+            else if(key == "write") cfg.write_frac = stod(val);
+            else if(key == "churn") cfg.churn = stod(val);
+            else if(key == "zipf_s") cfg.zipf_s = stod(val);
+            else if(key == "mu") cfg.lognorm_mu = stod(val);
+            else if(key == "sigma") cfg.lognorm_sigma = stod(val);
+            else if(key == "dist"){
+                if(val == "uniform") cfg.size_dist = WorkloadConfig::UNIFORM;
+                else if(val == "zipf") cfg.size_dist = WorkloadConfig::ZIPF;
+                else if(val == "lognormal") cfg.size_dist = WorkloadConfig::LOGNORMAL;
+                else{
+                    cerr << "Unknown size distribution: " << val << "\n";
+                    exit(EXIT_FAILURE);
+                }
             }
-        } 
-        else if (operation == "DELETE_FILE") {
-            mcfs.delete_file(file_name);
-            cfs.delete_file(file_name);
-            ifs.delete_file(file_name);
-            lfs.delete_file(file_name);
-        } 
-        else {
-            cout << "Invalid operation: " << operation << "\n";
+            else{
+                cerr << "Unknown --gen option: " << arg << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        WorkloadGenerator gen(cfg);
+        gen.generate(ops, names);
+        if(!out.empty()){
+            if(!write_text_trace(out.c_str(), ops, names))
+                exit(EXIT_FAILURE);
+            cout << "Generated " << ops.size() << " operations to " << out << "\n";
+            return 0;
         }
     }
+    else if(!load_trace(argv[1], ops, names))
+        exit(EXIT_FAILURE);
+
+    // ./fs trace.txt --compile trace.bin : pre-compile the trace and exit.
+    if(argc >= 4 && string(argv[2]) == "--compile"){
+        if(!write_binary_trace(argv[3], ops, names))
+            exit(EXIT_FAILURE);
+        cout << "Compiled " << ops.size() << " operations to " << argv[3] << "\n";
+        return 0;
+    }
+
+    // ./fs trace.txt --async : the indexed class replays through the
+    // two-stage pipeline instead of the serial loop; results must match.
+    bool use_async = false;
+    for(int i = 2; i < argc; i++)
+        if(string(argv[i]) == "--async")
+            use_async = true;
+
+    ModifiedContiguousFileSystem<500> mcfs;
+    LinkedFileSystem<500> lfs;
+    LinkedFileSystem<500, FAT> flfs;
+    IndexedFileSystem<500> ifs;
+    ConcurrentFileSystem<IndexedFileSystem<500>> aifs;
+    // strategies fixed at build time, so the fit search is inlined into the
+    // hot path instead of dispatched through the runtime enum.
+    ContiguousFileSystem<500, BEST_FIT> cfs;
+    ContiguousFileSystem<500, BUDDY> bcfs;
+    HybridFileSystem<500> hfs;
+
+    // batch runs only care about the final numbers; per-op logging is opt-in.
+    mcfs.set_verbosity(QUIET);
+    lfs.set_verbosity(QUIET);
+    flfs.set_verbosity(QUIET);
+    ifs.set_verbosity(QUIET);
+    aifs.set_verbosity(QUIET);
+    cfs.set_verbosity(QUIET);
+    bcfs.set_verbosity(QUIET);
+    hfs.set_verbosity(QUIET);
+
+    // the instances share no state, so each replays the trace on its own
+    // thread; per-filesystem counters live in the results and are read after join.
+    ReplayResult r_mcfs, r_cfs, r_bcfs, r_ifs, r_lfs, r_flfs, r_hfs;
+
+    thread t_mcfs([&]{ r_mcfs = replay_trace(mcfs, ops, names); });
+    thread t_cfs([&]{ r_cfs = replay_trace(cfs, ops, names); });
+    thread t_bcfs([&]{ r_bcfs = replay_trace(bcfs, ops, names); });
+    thread t_ifs([&]{
+        if(use_async)
+            r_ifs = replay_trace_async(aifs, ops, names);
+        else
+            r_ifs = replay_trace(ifs, ops, names);
+    });
+    thread t_lfs([&]{ r_lfs = replay_trace(lfs, ops, names); });
+    thread t_flfs([&]{ r_flfs = replay_trace(flfs, ops, names); });
+    thread t_hfs([&]{ r_hfs = replay_trace(hfs, ops, names); });
+
+    t_mcfs.join();
+    t_cfs.join();
+    t_bcfs.join();
+    t_ifs.join();
+    t_lfs.join();
+    t_flfs.join();
+    t_hfs.join();
+
+    int cfs_time = r_cfs.time, lfs_time = r_lfs.time, mcfs_time = r_mcfs.time;
+    int ifs_time = r_ifs.time, flfs_time = r_flfs.time, bcfs_time = r_bcfs.time;
+    int success_cfs = r_cfs.success, success_lfs = r_lfs.success, success_mcfs = r_mcfs.success;
+    int success_ifs = r_ifs.success, success_flfs = r_flfs.success;
+    int success_bcfs = r_bcfs.success;
+    int hfs_time = r_hfs.time, success_hfs = r_hfs.success;
 
     cout << "\nStorage efficiency\n";
     cout << "cfs: " << cfs.get_storage_efficiency() << endl;
+    cout << "bcfs: " << bcfs.get_storage_efficiency() << endl;
     cout << "lfs: " << lfs.get_storage_efficiency() << endl;
-    cout << "ifs: " << ifs.get_storage_efficiency() << endl;
+    cout << "flfs: " << flfs.get_storage_efficiency() << endl;
+    cout << "ifs: " << (use_async ? aifs.get_storage_efficiency() : ifs.get_storage_efficiency()) << endl;
     cout << "mcfs: " << mcfs.get_storage_efficiency() << endl;
+    cout << "hfs: " << hfs.get_storage_efficiency() << endl;
 
     cout << "\nAverage block accesses for read/write queries\n";
     cout << "cfs " << (float)cfs_time /success_cfs  << endl;
+    cout << "bcfs " << (float)bcfs_time /success_bcfs << endl;
     cout << "lfs " << (float)lfs_time /success_lfs << endl;
+    cout << "flfs " << (float)flfs_time /success_flfs << endl;
     cout << "ifs "  << (float)ifs_time /success_ifs << endl;
     cout << "mcfs " << (float)mcfs_time /success_mcfs << endl;
+    cout << "hfs " << (float)hfs_time /success_hfs << endl;
+
+    auto mix = hfs.layout_mix();
+    cout << "\nhfs layout mix : " << mix.first << " contiguous, " << mix.second << " indexed\n";
+
+    cout << "\nHost metadata footprint (KiB)\n";
+    cout << "cfs " << cfs.get_memory_footprint().total() / 1024.0 << endl;
+    cout << "bcfs " << bcfs.get_memory_footprint().total() / 1024.0 << endl;
+    cout << "lfs " << lfs.get_memory_footprint().total() / 1024.0 << endl;
+    cout << "flfs " << flfs.get_memory_footprint().total() / 1024.0 << endl;
+    cout << "ifs " << (use_async ? aifs.get_memory_footprint().total() : ifs.get_memory_footprint().total()) / 1024.0 << endl;
+    cout << "mcfs " << mcfs.get_memory_footprint().total() / 1024.0 << endl;
+    cout << "hfs " << hfs.get_memory_footprint().total() / 1024.0 << endl;
+
+    auto frag = cfs.get_fragmentation_stats();
+    cout << "\ncfs fragmentation : " << frag.hole_count << " holes, largest "
+         << frag.largest_hole << ", mean " << frag.mean_hole
+         << ", external " << frag.external_frag << endl;
 }
 